@@ -0,0 +1,96 @@
+#include "AsyncEngine.hpp"
+#include <algorithm>
+#include <queue>
+
+AsyncEngine::AsyncEngine() : multi(curl_multi_init()) {
+    worker = std::thread(&AsyncEngine::run, this);
+}
+
+AsyncEngine::~AsyncEngine() {
+    stopping = true;
+    curl_multi_wakeup(multi);
+    worker.join();
+    curl_multi_cleanup(multi);
+}
+
+bool AsyncEngine::submit(CURL* curl, Completion completion, Clock::time_point startAt) {
+    if (!multi || stopping) return false;
+
+    Job* job = new Job{ curl, std::move(completion), startAt };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(job);
+    }
+    curl_multi_wakeup(multi);
+    return true;
+}
+
+void AsyncEngine::finish(Job* job, CURLcode result) {
+    try {
+        job->completion(result);
+    }
+    catch (...) {}
+    delete job;
+}
+
+void AsyncEngine::run() {
+    if (!multi) return;
+
+    std::vector<Job*> incoming;
+    std::unordered_set<Job*> running;
+    std::priority_queue<Job*, std::vector<Job*>, LaterStart> waiting; // soonest start first
+
+    while (!stopping) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            incoming.swap(pending);
+        }
+        for (Job* job : incoming) waiting.push(job);
+        incoming.clear();
+
+        for (Clock::time_point now = Clock::now(); !waiting.empty() && waiting.top()->startAt <= now;) {
+            Job* job = waiting.top();
+            waiting.pop();
+            curl_easy_setopt(job->curl, CURLOPT_PRIVATE, job);
+            if (curl_multi_add_handle(multi, job->curl) != CURLM_OK) {
+                finish(job, CURLE_FAILED_INIT);
+                continue;
+            }
+            running.insert(job);
+        }
+
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
+
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            Job* job = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &job);
+            CURLcode result = message->data.result;
+            curl_multi_remove_handle(multi, job->curl);
+            running.erase(job);
+            finish(job, result);
+        }
+
+        int timeoutMs = 1000;
+        if (!waiting.empty()) {
+            auto untilStart = std::chrono::duration_cast<std::chrono::milliseconds>(waiting.top()->startAt - Clock::now()).count() + 1;
+            timeoutMs = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(timeoutMs, untilStart)));
+        }
+        curl_multi_poll(multi, NULL, 0, timeoutMs, NULL);
+    }
+
+    for (Job* job : running) {
+        curl_multi_remove_handle(multi, job->curl);
+        finish(job, CURLE_ABORTED_BY_CALLBACK);
+    }
+    for (; !waiting.empty(); waiting.pop()) finish(waiting.top(), CURLE_ABORTED_BY_CALLBACK);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        incoming.swap(pending);
+    }
+    for (Job* job : incoming) finish(job, CURLE_ABORTED_BY_CALLBACK);
+}
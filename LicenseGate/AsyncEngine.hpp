@@ -0,0 +1,51 @@
+#ifndef LICENSE_GATE_ASYNC_ENGINE_H
+#define LICENSE_GATE_ASYNC_ENGINE_H
+
+#include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// One I/O thread driving every asynchronous transfer of a client through a curl multi
+// handle. Pending transfers cost a multi entry each, not a thread. Completions run on the
+// I/O thread; transfers still running at shutdown complete with CURLE_ABORTED_BY_CALLBACK.
+class AsyncEngine {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Completion = std::function<void(CURLcode)>;
+
+    AsyncEngine();
+    ~AsyncEngine();
+    AsyncEngine(const AsyncEngine&) = delete;
+    AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+    // Takes a prepared easy handle; ownership of the handle stays with the caller, who
+    // gets it back when the completion runs. The transfer starts no earlier than startAt.
+    bool submit(CURL* curl, Completion completion, Clock::time_point startAt = Clock::time_point());
+
+private:
+    struct Job {
+        CURL* curl;
+        Completion completion;
+        Clock::time_point startAt;
+    };
+
+    struct LaterStart {
+        bool operator()(const Job* a, const Job* b) const { return a->startAt > b->startAt; }
+    };
+
+    void run();
+    static void finish(Job* job, CURLcode result);
+
+    CURLM* multi;
+    std::mutex mutex;
+    std::vector<Job*> pending;
+    std::atomic<bool> stopping{ false };
+    std::thread worker;
+};
+
+#endif // LICENSE_GATE_ASYNC_ENGINE_H
@@ -0,0 +1,144 @@
+#include "Base64.hpp"
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LICENSE_GATE_BASE64_SSSE3
+#define LICENSE_GATE_BASE64_SSSE3_TARGET __attribute__((target("ssse3")))
+#include <tmmintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define LICENSE_GATE_BASE64_SSSE3
+#define LICENSE_GATE_BASE64_SSSE3_TARGET
+#include <intrin.h>
+#include <tmmintrin.h>
+#endif
+
+namespace {
+    constexpr unsigned char invalid = 0xFF;
+
+    struct DecodeTable {
+        unsigned char values[256];
+
+        constexpr DecodeTable() : values() {
+            const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int i = 0; i < 256; ++i) values[i] = invalid;
+            for (int i = 0; i < 64; ++i) values[static_cast<unsigned char>(alphabet[i])] = static_cast<unsigned char>(i);
+        }
+
+        unsigned operator[](char c) const {
+            return values[static_cast<unsigned char>(c)];
+        }
+    };
+
+    constexpr DecodeTable table;
+
+    void store(uint32_t triple, unsigned char* dst, size_t count) {
+        dst[0] = static_cast<unsigned char>(triple >> 16);
+        if (count > 1) dst[1] = static_cast<unsigned char>(triple >> 8);
+        if (count > 2) dst[2] = static_cast<unsigned char>(triple);
+    }
+
+    // Groups of four without padding. invalid has the high bit set, which no sextet does.
+    bool decodeGroups(const char* src, size_t groups, unsigned char* dst) {
+        for (size_t i = 0; i < groups; ++i, src += 4, dst += 3) {
+            unsigned a = table[src[0]], b = table[src[1]], c = table[src[2]], d = table[src[3]];
+            if ((a | b | c | d) & 0x80) return false;
+            store(a << 18 | b << 12 | c << 6 | d, dst, 3);
+        }
+        return true;
+    }
+
+    // The final group, which may end in "=" or "==".
+    bool decodeLastGroup(const char* src, unsigned char* dst, size_t& written) {
+        size_t padding = src[3] != '=' ? 0 : src[2] == '=' ? 2 : 1;
+        unsigned a = table[src[0]], b = table[src[1]];
+        unsigned c = padding == 2 ? 0 : table[src[2]];
+        unsigned d = padding >= 1 ? 0 : table[src[3]];
+        if ((a | b | c | d) & 0x80) return false;
+
+        written = 3 - padding;
+        store(a << 18 | b << 12 | c << 6 | d, dst, written);
+        return true;
+    }
+
+#ifdef LICENSE_GATE_BASE64_SSSE3
+    bool cpuHasSsse3() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    // Decodes 16 characters into 12 bytes per step, validating with two nibble lookups. Every
+    // step stores 16 bytes, so it stops while at least 8 characters, and so at least 4 output
+    // bytes, remain; the final group, which may be padded, is always left to the scalar loop.
+    LICENSE_GATE_BASE64_SSSE3_TARGET
+    bool decodeBlocks(const char*& src, const char* end, unsigned char*& dst) {
+        const __m128i lutLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lutHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask2F = _mm_set1_epi8(0x2F);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        while (end - src >= 24) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(block, 4), mask2F);
+            __m128i lowNibbles = _mm_and_si128(block, mask2F);
+            __m128i classes = _mm_and_si128(_mm_shuffle_epi8(lutLow, lowNibbles), _mm_shuffle_epi8(lutHigh, highNibbles));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(classes, _mm_setzero_si128())) != 0xFFFF) return false;
+
+            __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(block, mask2F), highNibbles));
+            __m128i sextets = _mm_add_epi8(block, roll);
+            __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+            __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(triples, pack));
+
+            src += 16;
+            dst += 12;
+        }
+        return true;
+    }
+#endif
+}
+
+bool Base64::decodeScalar(std::string_view encoded, unsigned char* out, size_t& decodedSize) {
+    if (encoded.size() % 4 != 0) return false;
+    if (encoded.empty()) {
+        decodedSize = 0;
+        return true;
+    }
+
+    size_t groups = encoded.size() / 4 - 1;
+    size_t last = 0;
+    if (!decodeGroups(encoded.data(), groups, out)) return false;
+    if (!decodeLastGroup(encoded.data() + groups * 4, out + groups * 3, last)) return false;
+    decodedSize = groups * 3 + last;
+    return true;
+}
+
+bool Base64::decode(std::string_view encoded, unsigned char* out, size_t& decodedSize) {
+#ifdef LICENSE_GATE_BASE64_SSSE3
+    if (encoded.size() % 4 == 0 && vectorized()) {
+        const char* src = encoded.data();
+        unsigned char* dst = out;
+        if (!decodeBlocks(src, src + encoded.size(), dst)) return false;
+
+        size_t tail = 0;
+        if (!decodeScalar(encoded.substr(src - encoded.data()), dst, tail)) return false;
+        decodedSize = (dst - out) + tail;
+        return true;
+    }
+#endif
+    return decodeScalar(encoded, out, decodedSize);
+}
+
+bool Base64::vectorized() {
+#ifdef LICENSE_GATE_BASE64_SSSE3
+    static const bool supported = cpuHasSsse3();
+    return supported;
+#else
+    return false;
+#endif
+}
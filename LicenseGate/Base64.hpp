@@ -0,0 +1,27 @@
+#ifndef LICENSE_GATE_BASE64_H
+#define LICENSE_GATE_BASE64_H
+
+#include <cstddef>
+#include <string_view>
+
+// Strict decoder for padded standard base64 (RFC 4648 section 4). The input length must be a
+// multiple of four and '=' may only appear as one or two trailing padding characters;
+// whitespace and every other byte outside the alphabet is rejected. Blocks of 16 characters
+// are decoded with SSSE3 when the CPU has it, the rest with a table-driven scalar loop.
+class Base64 {
+public:
+    static constexpr size_t maxDecodedSize(size_t encodedSize) {
+        return encodedSize / 4 * 3;
+    }
+
+    // Decodes into out, which must hold maxDecodedSize(encoded.size()) bytes. On success
+    // decodedSize is the number of bytes written; on failure the contents of out are undefined.
+    static bool decode(std::string_view encoded, unsigned char* out, size_t& decodedSize);
+
+    // The reference path; decode() must agree with it on every input.
+    static bool decodeScalar(std::string_view encoded, unsigned char* out, size_t& decodedSize);
+
+    static bool vectorized();
+};
+
+#endif // LICENSE_GATE_BASE64_H
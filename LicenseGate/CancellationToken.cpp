@@ -0,0 +1,33 @@
+#include "CancellationToken.hpp"
+#include <algorithm>
+
+CancellationToken::CancellationToken() : state(std::make_shared<State>()) {
+}
+
+void CancellationToken::cancel() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->cancelled.exchange(true, std::memory_order_acq_rel)) return;
+    state->changed.notify_all();
+    for (const std::function<void()>* listener : state->listeners) (*listener)();
+}
+
+bool CancellationToken::sleepUntil(std::chrono::steady_clock::time_point until) const {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    return !state->changed.wait_until(lock, until, [this]() { return state->cancelled.load(std::memory_order_relaxed); });
+}
+
+// Listeners are called under the state mutex, so once the destructor has removed one it is
+// no longer running either.
+CancellationToken::Listener::Listener(const CancellationToken& token, std::function<void()> onCancel)
+    : state(token.state), onCancel(std::move(onCancel)) {
+    State& shared = *state;
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.listeners.push_back(&this->onCancel);
+    if (shared.cancelled.load(std::memory_order_relaxed)) this->onCancel();
+}
+
+CancellationToken::Listener::~Listener() {
+    State& shared = *state;
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.listeners.erase(std::find(shared.listeners.begin(), shared.listeners.end(), &onCancel));
+}
@@ -0,0 +1,51 @@
+#ifndef LICENSE_GATE_CANCELLATION_TOKEN_H
+#define LICENSE_GATE_CANCELLATION_TOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Lets another thread stop verifications that were handed this token. Copies share their
+// state, so cancelling any copy cancels them all, and a cancelled token stays cancelled.
+class CancellationToken {
+    struct State;
+
+public:
+    CancellationToken();
+
+    void cancel();
+    bool cancelled() const { return state->cancelled.load(std::memory_order_acquire); }
+
+    // Runs onCancel when the token is cancelled, from the cancelling thread, for as long as
+    // the listener lives. onCancel must be quick and must not use the token.
+    class Listener {
+    public:
+        Listener(const CancellationToken& token, std::function<void()> onCancel);
+        ~Listener();
+        Listener(const Listener&) = delete;
+        Listener& operator=(const Listener&) = delete;
+
+    private:
+        std::shared_ptr<State> state;
+        std::function<void()> onCancel;
+    };
+
+    // Sleeps until the time given or until the token is cancelled; false if it was cancelled.
+    bool sleepUntil(std::chrono::steady_clock::time_point until) const;
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{ false };
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<const std::function<void()>*> listeners;
+    };
+
+    std::shared_ptr<State> state;
+};
+
+#endif // LICENSE_GATE_CANCELLATION_TOKEN_H
@@ -0,0 +1,107 @@
+#include "ConnectionPool.hpp"
+
+ConnectionPool::ConnectionPool() {
+    static std::once_flag curlInitialized;
+    std::call_once(curlInitialized, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // CURL_LOCK_DATA_CONNECT is deliberately not shared: libcurl documents connection cache
+    // sharing as unsafe between concurrent threads. Each pooled handle keeps its own cache.
+}
+
+ConnectionPool::~ConnectionPool() {
+    for (CURL* handle : idle) curl_easy_cleanup(handle);
+    curl_share_cleanup(share);
+}
+
+void ConnectionPool::setPoolSize(size_t poolSize) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options.poolSize = poolSize > 0 ? poolSize : 1;
+}
+
+void ConnectionPool::setIdleTimeout(long seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options.idleTimeoutSeconds = seconds;
+}
+
+void ConnectionPool::setMaxConnectionAge(long seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options.maxConnectionAgeSeconds = seconds;
+}
+
+// Also applies to the idle handles, since every new connection asks for its TLS context anew.
+bool ConnectionPool::setTlsSessionStore(std::shared_ptr<TlsSessionStore> store) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options.tlsSessions = std::move(store);
+    bool attached = true;
+    for (CURL* handle : idle) attached = applyOptions(handle, options) && attached;
+    return attached;
+}
+
+ConnectionPool::Options ConnectionPool::getOptions() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return options;
+}
+
+CURL* ConnectionPool::acquire() {
+    Options current;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            CURL* handle = idle.back();
+            idle.pop_back();
+            return handle;
+        }
+        current = options;
+    }
+
+    CURL* handle = curl_easy_init();
+    if (handle) applyOptions(handle, current);
+    return handle;
+}
+
+void ConnectionPool::release(CURL* handle) {
+    // Resetting keeps the connection, DNS and session caches but drops per-request options.
+    curl_easy_reset(handle);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (idle.size() >= options.poolSize) {
+        lock.unlock();
+        curl_easy_cleanup(handle);
+        return;
+    }
+    Options current = options;
+    lock.unlock();
+
+    applyOptions(handle, current);
+
+    lock.lock();
+    idle.push_back(handle);
+}
+
+bool ConnectionPool::applyOptions(CURL* handle, const Options& current) {
+    curl_easy_setopt(handle, CURLOPT_SHARE, share);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(handle, CURLOPT_MAXCONNECTS, (long)current.poolSize);
+    curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, current.idleTimeoutSeconds);
+#if LIBCURL_VERSION_NUM >= 0x075000
+    curl_easy_setopt(handle, CURLOPT_MAXLIFETIME_CONN, current.maxConnectionAgeSeconds);
+#endif
+    return !current.tlsSessions || current.tlsSessions->attach(handle);
+}
+
+void ConnectionPool::lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<ConnectionPool*>(userptr)->shareLocks[data].lock();
+}
+
+void ConnectionPool::unlockShare(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<ConnectionPool*>(userptr)->shareLocks[data].unlock();
+}
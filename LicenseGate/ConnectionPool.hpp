@@ -0,0 +1,64 @@
+#ifndef LICENSE_GATE_CONNECTION_POOL_H
+#define LICENSE_GATE_CONNECTION_POOL_H
+
+#include <curl/curl.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "TlsSessionStore.hpp"
+
+// Keeps curl easy handles alive between requests so that keep-alive connections,
+// DNS entries and TLS sessions survive from one verify to the next. Each handle keeps
+// its own connections; DNS and TLS sessions are shared between all pooled handles.
+class ConnectionPool {
+public:
+    struct Options {
+        size_t poolSize = 8;
+        long idleTimeoutSeconds = 118;
+        long maxConnectionAgeSeconds = 0;
+        // Persists TLS sessions across restarts; the shared cache above only lives as long as the pool.
+        std::shared_ptr<TlsSessionStore> tlsSessions;
+    };
+
+    class Lease {
+    public:
+        Lease(ConnectionPool& pool) : pool(&pool), handle(pool.acquire()) {}
+        ~Lease() { if (handle) pool->release(handle); }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        CURL* get() const { return handle; }
+        explicit operator bool() const { return handle != nullptr; }
+
+    private:
+        ConnectionPool* pool;
+        CURL* handle;
+    };
+
+    ConnectionPool();
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    void setPoolSize(size_t poolSize);
+    void setIdleTimeout(long seconds);
+    void setMaxConnectionAge(long seconds);
+    bool setTlsSessionStore(std::shared_ptr<TlsSessionStore> store);
+    Options getOptions();
+
+    CURL* acquire();
+    void release(CURL* handle);
+
+private:
+    static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockShare(CURL* handle, curl_lock_data data, void* userptr);
+    bool applyOptions(CURL* handle, const Options& options);
+
+    CURLSH* share;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+    std::mutex mutex;
+    std::vector<CURL*> idle;
+    Options options;
+};
+
+#endif // LICENSE_GATE_CONNECTION_POOL_H
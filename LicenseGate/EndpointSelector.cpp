@@ -0,0 +1,148 @@
+#include "EndpointSelector.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // An endpoint at a 10% error rate scores like one twice as slow.
+    constexpr double errorPenalty = 10;
+    constexpr uint64_t explorePeriod = 32;
+
+    int64_t ticks(EndpointSelector::Clock::time_point time) {
+        return time.time_since_epoch().count();
+    }
+}
+
+EndpointSelector::EndpointSelector(std::vector<std::string> urls, const Options& options) : options(options) {
+    for (std::string& url : urls) endpoints.emplace_back(new Endpoint(std::move(url)));
+    latencies.reserve(latencyWindow);
+}
+
+size_t EndpointSelector::pick(size_t excluded) {
+    size_t count = endpoints.size();
+    if (count == 0) return none;
+    if (count == 1) return excluded == 0 ? none : 0;
+
+    int64_t now = ticks(Clock::now());
+    uint64_t pickNumber = picks.fetch_add(1, std::memory_order_relaxed);
+
+    if (pickNumber % explorePeriod == explorePeriod - 1) {
+        size_t first = static_cast<size_t>((pickNumber / explorePeriod) * 2654435761u % count);
+        for (size_t i = 0; i < count; ++i) {
+            size_t candidate = (first + i) % count;
+            if (candidate != excluded && endpoints[candidate]->openUntil.load(std::memory_order_relaxed) <= now) return candidate;
+        }
+    }
+
+    size_t best = none, soonest = none;
+    double bestScore = 0;
+    int64_t soonestReopen = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i == excluded) continue;
+        const Endpoint& endpoint = *endpoints[i];
+
+        int64_t openUntil = endpoint.openUntil.load(std::memory_order_relaxed);
+        if (openUntil > now) {
+            if (soonest == none || openUntil < soonestReopen) {
+                soonest = i;
+                soonestReopen = openUntil;
+            }
+            continue;
+        }
+
+        double errorRate = endpoint.errorRate.load(std::memory_order_relaxed);
+        double score;
+        if (endpoint.measured.load(std::memory_order_relaxed)) score = endpoint.latencyNanoseconds.load(std::memory_order_relaxed) * (1 + errorPenalty * errorRate);
+        else if (errorRate == 0) return i; // never tried
+        else score = std::numeric_limits<double>::max(); // only ever failed
+
+        if (best == none || score < bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+    if (best != none || excluded != none) return best;
+    return soonest;
+}
+
+void EndpointSelector::record(size_t endpoint, std::chrono::nanoseconds latency, bool success) {
+    Endpoint& target = *endpoints[endpoint];
+    target.requests.fetch_add(1, std::memory_order_relaxed);
+    if (!success) target.failures.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(target.mutex);
+        double weight = options.ewmaWeight;
+        if (success) {
+            double sample = static_cast<double>(latency.count());
+            double previous = target.latencyNanoseconds.load(std::memory_order_relaxed);
+            target.latencyNanoseconds.store(target.measured.load(std::memory_order_relaxed) ? previous + weight * (sample - previous) : sample,
+                std::memory_order_relaxed);
+            target.measured.store(true, std::memory_order_relaxed);
+        }
+        double errorRate = target.errorRate.load(std::memory_order_relaxed);
+        target.errorRate.store(errorRate + weight * ((success ? 0.0 : 1.0) - errorRate), std::memory_order_relaxed);
+
+        if (success) {
+            target.consecutiveFailures.store(0, std::memory_order_relaxed);
+            target.openUntil.store(0, std::memory_order_relaxed);
+        }
+        else if (target.consecutiveFailures.fetch_add(1, std::memory_order_relaxed) + 1 >= options.failureThreshold) {
+            target.openUntil.store(ticks(Clock::now() + options.breakerCooldown), std::memory_order_relaxed);
+        }
+    }
+
+    if (success) recordLatency(latency);
+}
+
+void EndpointSelector::recordAbandoned(size_t endpoint, std::chrono::nanoseconds elapsed) {
+    Endpoint& target = *endpoints[endpoint];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    double sample = static_cast<double>(elapsed.count());
+    double previous = target.latencyNanoseconds.load(std::memory_order_relaxed);
+    if (!target.measured.load(std::memory_order_relaxed)) target.latencyNanoseconds.store(sample, std::memory_order_relaxed);
+    else if (sample > previous) target.latencyNanoseconds.store(previous + options.ewmaWeight * (sample - previous), std::memory_order_relaxed);
+    target.measured.store(true, std::memory_order_relaxed);
+}
+
+void EndpointSelector::recordLatency(std::chrono::nanoseconds latency) {
+    if (!options.hedge || endpoints.size() < 2) return;
+
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    if (latencies.size() < latencyWindow) latencies.push_back(latency.count());
+    else latencies[latencyCursor] = latency.count();
+    latencyCursor = (latencyCursor + 1) % latencyWindow;
+    if (++latencySamples % hedgeRecomputeEvery != 0) return;
+
+    std::vector<int64_t> sorted(latencies);
+    size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(options.hedgePercentile * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    int64_t minimum = std::chrono::duration_cast<std::chrono::nanoseconds>(options.minHedgeDelay).count();
+    hedgeDelayNanoseconds.store(std::max(sorted[rank], minimum), std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds EndpointSelector::hedgeDelay() const {
+    return std::chrono::nanoseconds(hedgeDelayNanoseconds.load(std::memory_order_relaxed));
+}
+
+void EndpointSelector::countHedge(bool won) {
+    hedges.fetch_add(1, std::memory_order_relaxed);
+    if (won) hedgeWins.fetch_add(1, std::memory_order_relaxed);
+}
+
+EndpointSelector::Stats EndpointSelector::stats() const {
+    Stats stats;
+    int64_t now = ticks(Clock::now());
+    for (const auto& endpoint : endpoints) {
+        EndpointStats current;
+        current.url = endpoint->url;
+        current.latencySeconds = endpoint->latencyNanoseconds.load(std::memory_order_relaxed) / 1e9;
+        current.errorRate = endpoint->errorRate.load(std::memory_order_relaxed);
+        current.open = endpoint->openUntil.load(std::memory_order_relaxed) > now;
+        current.requests = endpoint->requests.load(std::memory_order_relaxed);
+        current.failures = endpoint->failures.load(std::memory_order_relaxed);
+        stats.endpoints.push_back(current);
+    }
+    stats.hedges = hedges.load(std::memory_order_relaxed);
+    stats.hedgeWins = hedgeWins.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,105 @@
+#ifndef LICENSE_GATE_ENDPOINT_SELECTOR_H
+#define LICENSE_GATE_ENDPOINT_SELECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Chooses among several validation servers. Every endpoint keeps an exponentially weighted
+// moving average of its latency and error rate; picks go to the lowest latency scaled by
+// errors, with an occasional random pick so that a recovered endpoint gets measured again.
+// After failureThreshold consecutive failures an endpoint's circuit breaker opens and it is
+// skipped for breakerCooldown. After that it is eligible again, but a single further failure
+// reopens it until a success resets the count. If every breaker is open, the endpoint that
+// reopens first is used. Picks read atomics only; recording takes a per-endpoint lock.
+class EndpointSelector {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        double ewmaWeight = 0.2;
+        int failureThreshold = 5;
+        std::chrono::milliseconds breakerCooldown = std::chrono::seconds(30);
+        // Hedging: when the first server has not answered within hedgePercentile of recent
+        // latencies (never sooner than minHedgeDelay), the same request goes to a second one.
+        bool hedge = false;
+        double hedgePercentile = 0.95;
+        std::chrono::milliseconds minHedgeDelay = std::chrono::milliseconds(1);
+    };
+
+    struct EndpointStats {
+        std::string url;
+        double latencySeconds = 0;
+        double errorRate = 0;
+        bool open = false;
+        uint64_t requests = 0;
+        uint64_t failures = 0;
+    };
+
+    struct Stats {
+        std::vector<EndpointStats> endpoints;
+        uint64_t hedges = 0;
+        uint64_t hedgeWins = 0;
+    };
+
+    static constexpr size_t none = static_cast<size_t>(-1);
+
+    EndpointSelector(std::vector<std::string> urls, const Options& options);
+
+    size_t size() const { return endpoints.size(); }
+    const std::string& url(size_t endpoint) const { return endpoints[endpoint]->url; }
+    const Options& getOptions() const { return options; }
+
+    // The endpoint for a new request. With excluded set, this is an endpoint for a second
+    // attempt: never excluded itself nor one whose breaker is open, and none if there is none.
+    size_t pick(size_t excluded = none);
+    void record(size_t endpoint, std::chrono::nanoseconds latency, bool success);
+    // A transfer given up after elapsed, e.g. the loser of a hedge. Its latency is at least
+    // elapsed, so the average only moves up; whether it would have succeeded is unknown, so
+    // the error rate, the breaker and the hedge percentile are left alone.
+    void recordAbandoned(size_t endpoint, std::chrono::nanoseconds elapsed);
+
+    // Zero until enough latencies have been recorded to estimate the percentile.
+    std::chrono::nanoseconds hedgeDelay() const;
+    void countHedge(bool won);
+
+    Stats stats() const;
+
+private:
+    struct Endpoint {
+        explicit Endpoint(std::string url) : url(std::move(url)) {}
+
+        const std::string url;
+        std::mutex mutex;
+        std::atomic<double> latencyNanoseconds{ 0 };
+        std::atomic<double> errorRate{ 0 };
+        std::atomic<bool> measured{ false };
+        std::atomic<int> consecutiveFailures{ 0 };
+        std::atomic<int64_t> openUntil{ 0 }; // Clock ticks
+        std::atomic<uint64_t> requests{ 0 };
+        std::atomic<uint64_t> failures{ 0 };
+    };
+
+    static constexpr size_t latencyWindow = 256;
+    static constexpr size_t hedgeRecomputeEvery = 32;
+
+    void recordLatency(std::chrono::nanoseconds latency);
+
+    Options options;
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+    std::atomic<uint64_t> picks{ 0 };
+
+    std::mutex latencyMutex;
+    std::vector<int64_t> latencies;
+    size_t latencyCursor = 0;
+    uint64_t latencySamples = 0;
+    std::atomic<int64_t> hedgeDelayNanoseconds{ 0 };
+    std::atomic<uint64_t> hedges{ 0 };
+    std::atomic<uint64_t> hedgeWins{ 0 };
+};
+
+#endif // LICENSE_GATE_ENDPOINT_SELECTOR_H
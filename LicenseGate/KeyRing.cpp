@@ -0,0 +1,139 @@
+#include "KeyRing.hpp"
+#include <openssl/pem.h>
+#include <openssl/sha.h>
+#include <algorithm>
+#include <mutex>
+
+namespace {
+    // Each thread keeps a verify context already initialised for the keys it has used, and one
+    // SHA-256 context that is reinitialised in place. Hashing separately and verifying the digest
+    // reuses both, where copying a DigestVerify context duplicated the digest and key state on
+    // every call.
+    class VerifyContexts {
+    public:
+        ~VerifyContexts() {
+            for (auto& entry : initialized) EVP_PKEY_CTX_free(entry.second);
+            EVP_MD_CTX_free(digest);
+        }
+
+        bool sha256(const unsigned char* message, size_t messageLength, unsigned char* hash) {
+            if (!digest) {
+                if (!(digest = EVP_MD_CTX_new())) return false;
+                if (EVP_DigestInit_ex(digest, EVP_sha256(), NULL) != 1) {
+                    EVP_MD_CTX_free(digest);
+                    digest = nullptr;
+                    return false;
+                }
+            }
+            else if (EVP_DigestInit_ex(digest, NULL, NULL) != 1) {
+                return false;
+            }
+            unsigned int hashLength = 0;
+            return EVP_DigestUpdate(digest, message, messageLength) == 1 && EVP_DigestFinal_ex(digest, hash, &hashLength) == 1;
+        }
+
+        EVP_PKEY_CTX* forKey(EVP_PKEY* key) {
+            for (auto& entry : initialized) {
+                if (entry.first == key) return entry.second;
+            }
+
+            EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, NULL);
+            if (!ctx) return nullptr;
+            if (EVP_PKEY_verify_init(ctx) <= 0 || EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) <= 0) {
+                EVP_PKEY_CTX_free(ctx);
+                return nullptr;
+            }
+            if (initialized.size() == maxKeys) {
+                EVP_PKEY_CTX_free(initialized.front().second);
+                initialized.erase(initialized.begin());
+            }
+            initialized.emplace_back(key, ctx);
+            return ctx;
+        }
+
+    private:
+        static constexpr size_t maxKeys = 8;
+        // The context holds a reference on its key, so the pointer stays unique while cached.
+        std::vector<std::pair<EVP_PKEY*, EVP_PKEY_CTX*>> initialized;
+        EVP_MD_CTX* digest = nullptr;
+    };
+}
+
+KeyRing::KeyPtr KeyRing::parse(const std::string& publicKeyPem) {
+    BIO* bio = BIO_new_mem_buf(publicKeyPem.data(), (int)publicKeyPem.size());
+    if (!bio) return nullptr;
+    EVP_PKEY* key = PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    return key ? KeyPtr(key, EVP_PKEY_free) : nullptr;
+}
+
+bool KeyRing::add(const std::string& keyId, const std::string& publicKeyPem, const std::string& rotationGroup) {
+    KeyPtr key = parse(publicKeyPem);
+    if (!key) return false;
+
+    const std::string& group = rotationGroup.empty() ? keyId : rotationGroup;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (auto& entry : keys) {
+        if (entry.id == keyId) {
+            entry.group = group;
+            entry.key = std::move(key);
+            return true;
+        }
+    }
+    keys.push_back({ keyId, group, std::move(key) });
+    return true;
+}
+
+bool KeyRing::replaceAll(const std::string& keyId, const std::string& publicKeyPem) {
+    KeyPtr key = parse(publicKeyPem);
+
+    // One swap under the lock, so a concurrent verify never sees an empty ring in between.
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    keys.clear();
+    if (!key) return false;
+    keys.push_back({ keyId, keyId, std::move(key) });
+    return true;
+}
+
+bool KeyRing::remove(const std::string& keyId) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = std::find_if(keys.begin(), keys.end(), [&](const auto& entry) { return entry.id == keyId; });
+    if (it == keys.end()) return false;
+    keys.erase(it);
+    return true;
+}
+
+void KeyRing::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    keys.clear();
+}
+
+bool KeyRing::empty() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return keys.empty();
+}
+
+bool KeyRing::verify(const std::string& keyId, const unsigned char* signature, size_t signatureLength,
+    const unsigned char* message, size_t messageLength) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    auto preferred = std::find_if(keys.begin(), keys.end(), [&](const auto& entry) { return entry.id == keyId; });
+    if (preferred != keys.end() && verifyWith(preferred->key.get(), signature, signatureLength, message, messageLength))
+        return true;
+
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (it == preferred || (preferred != keys.end() && it->group != preferred->group)) continue;
+        if (verifyWith(it->key.get(), signature, signatureLength, message, messageLength)) return true;
+    }
+    return false;
+}
+
+bool KeyRing::verifyWith(EVP_PKEY* key, const unsigned char* signature, size_t signatureLength,
+    const unsigned char* message, size_t messageLength) {
+    thread_local VerifyContexts contexts;
+
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    EVP_PKEY_CTX* ctx = contexts.forKey(key);
+    if (!ctx || !contexts.sha256(message, messageLength, hash)) return false;
+    return EVP_PKEY_verify(ctx, signature, signatureLength, hash, SHA256_DIGEST_LENGTH) == 1;
+}
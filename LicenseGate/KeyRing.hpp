@@ -0,0 +1,44 @@
+#ifndef LICENSE_GATE_KEY_RING_H
+#define LICENSE_GATE_KEY_RING_H
+
+#include <openssl/evp.h>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Public keys parsed once and held by id. Verification tries the requested key first and then
+// the other keys of its rotation group, so an old and a new key can both be loaded during a
+// rotation without a signature by some other key on the ring passing for the requested one.
+// Only a key id that is not on the ring falls back to every key.
+class KeyRing {
+public:
+    // An empty rotation group puts the key in a group of its own, named after its id.
+    bool add(const std::string& keyId, const std::string& publicKeyPem, const std::string& rotationGroup = std::string());
+    bool replaceAll(const std::string& keyId, const std::string& publicKeyPem);
+    bool remove(const std::string& keyId);
+    void clear();
+    bool empty() const;
+
+    bool verify(const std::string& keyId, const unsigned char* signature, size_t signatureLength,
+        const unsigned char* message, size_t messageLength) const;
+
+private:
+    using KeyPtr = std::shared_ptr<EVP_PKEY>;
+
+    struct Entry {
+        std::string id;
+        std::string group;
+        KeyPtr key;
+    };
+
+    static KeyPtr parse(const std::string& publicKeyPem);
+    static bool verifyWith(EVP_PKEY* key, const unsigned char* signature, size_t signatureLength,
+        const unsigned char* message, size_t messageLength);
+
+    mutable std::shared_mutex mutex;
+    std::vector<Entry> keys;
+};
+
+#endif // LICENSE_GATE_KEY_RING_H
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
@@ -14,27 +15,42 @@
 #include <openssl/err.h>
 #include <openssl/sha.h>
 #include <vector>
+#include <algorithm>
+#include <future>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include "AsyncEngine.hpp"
+#include "Base64.hpp"
+#include "CancellationToken.hpp"
+#include "ConnectionPool.hpp"
+#include "EndpointSelector.hpp"
+#include "KeyRing.hpp"
+#include "LicenseGatePolicy.hpp"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "RateLimiter.hpp"
+#include "RefreshScheduler.hpp"
+#include "RequestCoalescer.hpp"
+#include "ResponseParser.hpp"
+#include "StringTable.hpp"
+#include "TlsSessionStore.hpp"
+#include "UrlEncoder.hpp"
+#include "VerdictCache.hpp"
+#include "VerdictStore.hpp"
 
 using json = nlohmann::json;
 
-class LicenseGate {
-private:
-    static constexpr const char* DEFAULT_SERVER = "https://api.licensegate.io";
-    std::string userId;
-    std::string publicRsaKey;
-    std::string validationServer = DEFAULT_SERVER;
-    bool useChallenges = false;
-    bool debug = false;
+template <typename ChallengePolicy = LicenseGatePolicy::Runtime, typename DebugPolicy = LicenseGatePolicy::Runtime,
+    typename CachePolicy = LicenseGatePolicy::Runtime>
+class BasicLicenseGate;
 
+// The results and the types that carry them, the same for every BasicLicenseGate.
+class LicenseGateBase {
 public:
-    LicenseGate(std::string userId);
-    LicenseGate(std::string userId, std::string publicRsaKey);
-
-    LicenseGate& setPublicRsaKey(const std::string& publicKey);
-    LicenseGate& setValidationServer(const std::string& server);
-    LicenseGate& enableChallenges();
-    LicenseGate& enableDebug();
-
     enum class ValidationType {
         VALID,
         NOT_FOUND,
@@ -45,7 +61,9 @@ public:
         RATE_LIMIT_EXCEEDED,
         FAILED_CHALLENGE,
         SERVER_ERROR,
-        CONNECTION_ERROR
+        CONNECTION_ERROR,
+        TIMEOUT,
+        CANCELLED
     };
 
     int NOT_FOUND = 1;
@@ -57,24 +75,250 @@ public:
     int FAILED_CHALLENGE = 7;
     int SERVER_ERROR = 8;
     int CONNECTION_ERROR = 0;
+    int TIMEOUT = 10;
+    int CANCELLED = 11;
+
+    struct BatchRequest {
+        std::string licenseKey;
+        std::string scope;
+        std::string metadata;
+    };
+
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    // Callbacks run on the client's I/O thread and should not block.
+    using VerifyCallback = std::function<void(ValidationType)>;
+
+    // A license that the client re-verifies in the background. Reading its verdict is a single
+    // atomic load; only the very first read may wait, for the first verification to finish.
+    class WatchedLicense {
+    public:
+        WatchedLicense() = default;
+
+        ValidationType verdict() const {
+            if (!watch) return ValidationType::CONNECTION_ERROR;
+            return static_cast<ValidationType>(watch->wait());
+        }
+        bool ready() const { return watch && watch->verdict.load(std::memory_order_acquire) != RefreshScheduler::noVerdict; }
+        explicit operator bool() const { return watch != nullptr; }
+
+    private:
+        template <typename, typename, typename> friend class BasicLicenseGate;
+        explicit WatchedLicense(std::shared_ptr<RefreshScheduler::Watch> watch) : watch(std::move(watch)) {}
+
+        std::shared_ptr<RefreshScheduler::Watch> watch;
+    };
+
+    // Runs when a refresh changes a watched verdict, on whichever thread finished the refresh:
+    // usually the client's I/O thread, but the refresh scheduler's thread when the verdict came
+    // from the cache, the verdict store or a coalesced request. It must not block.
+    using VerdictChangeCallback = std::function<void(ValidationType previous, ValidationType current)>;
+};
+
+// The client. Challenges, debug logging and the verdict cache each have a policy from
+// LicenseGatePolicy.hpp; LicenseGate leaves all three to the setters. The members are defined
+// in LicenseGateImpl.hpp. LicenseGate.cpp instantiates LicenseGate; a program that uses other
+// policies includes LicenseGateImpl.hpp in the files that use them.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+class BasicLicenseGate : public LicenseGateBase {
+    friend struct LicenseGateBenchmark;
+
+private:
+    static constexpr const char* DEFAULT_SERVER = "https://api.licensegate.io";
+
+    // Settings are never modified in place. Setters copy the current snapshot, change the
+    // copy and publish it; a verification reads one snapshot from start to finish without
+    // locking. Replaced snapshots are kept until the LicenseGate is destroyed, so setters are
+    // meant for configuration, not for calling per request.
+    struct Config {
+        std::shared_ptr<EndpointSelector> endpoints = std::make_shared<EndpointSelector>(std::vector<std::string>{ DEFAULT_SERVER }, EndpointSelector::Options());
+        std::string activeKeyId;
+        bool useChallenges = false;
+        std::shared_ptr<Logger> logger;
+        size_t batchConcurrency = 16;
+        std::shared_ptr<VerdictCache> verdictCache;
+        std::shared_ptr<VerdictStore> verdictStore;
+        std::shared_ptr<TlsSessionStore> tlsSessions;
+        std::shared_ptr<RateLimiter> rateLimiter;
+        bool prewarm = false;
+    };
+
+    std::string userId;
+    KeyRing keyRing;
+    std::mutex configMutex;
+    std::vector<std::unique_ptr<const Config>> configs;
+    std::atomic<const Config*> config{ nullptr };
+    ConnectionPool connectionPool;
+    RequestCoalescer requestCoalescer;
+    Metrics metrics;
+    mutable std::mutex refreshSchedulerMutex;
+    std::unique_ptr<RefreshScheduler> refreshScheduler;
+    std::mutex asyncEngineMutex;
+    std::unique_ptr<AsyncEngine> asyncEngine;
+    // Declared last so that background prewarms finish before anything they use is destroyed.
+    std::atomic<bool> prewarmCancelled{ false };
+    std::mutex prewarmMutex;
+    std::vector<std::future<void>> prewarms;
+
+public:
+    // One instance may be shared by any number of threads; all methods are thread-safe.
+    BasicLicenseGate(std::string userId);
+    BasicLicenseGate(std::string userId, std::string publicRsaKey);
+    ~BasicLicenseGate();
+
+    BasicLicenseGate& setPublicRsaKey(const std::string& publicKey);
+    BasicLicenseGate& addPublicRsaKey(const std::string& keyId, const std::string& publicKey);
+    // A key that signs for the same account as the keys already in rotationGroup, e.g. the new
+    // key of a rotation; the first key of an instance is in the group named after its userId.
+    BasicLicenseGate& addPublicRsaKey(const std::string& keyId, const std::string& publicKey, const std::string& rotationGroup);
+    BasicLicenseGate& removePublicRsaKey(const std::string& keyId);
+    BasicLicenseGate& setActiveKeyId(const std::string& keyId);
+    BasicLicenseGate& setValidationServer(const std::string& server);
+    BasicLicenseGate& setValidationServers(const std::vector<std::string>& servers);
+    BasicLicenseGate& setValidationServers(const std::vector<std::string>& servers, const EndpointSelector::Options& options);
+    // enableChallenges, enableDebug and enableCache have no effect when the policy is Disabled.
+    BasicLicenseGate& enableChallenges();
+    BasicLicenseGate& enableDebug();
+    BasicLicenseGate& enableDebug(const Logger::Options& options);
+    BasicLicenseGate& setConnectionPoolSize(size_t poolSize);
+    BasicLicenseGate& setConnectionIdleTimeout(long seconds);
+    BasicLicenseGate& setConnectionMaxAge(long seconds);
+    BasicLicenseGate& setBatchConcurrency(size_t maxInFlight);
+    BasicLicenseGate& enableCache();
+    BasicLicenseGate& enableCache(const VerdictCache::Options& options);
+    BasicLicenseGate& enableVerdictStore(const VerdictStore::Options& options);
+    BasicLicenseGate& enableTlsSessionCache(const std::string& path);
+    BasicLicenseGate& enableRateLimit(const RateLimiter::Options& options);
+    // Prewarms in the background now and again whenever the validation servers change.
+    BasicLicenseGate& enablePrewarm();
+
+    // Resolves and connects to every validation server, so that the first verification finds
+    // an open connection, and does the other one-time setup a verification needs.
+    void prewarm();
 
     ValidationType verify(const std::string& licenseKey);
     ValidationType verify(const std::string& licenseKey, const std::string& scope);
     ValidationType verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata);
 
+    // Gives up at the deadline, which covers waiting for the rate limiter or for another
+    // caller's request as well as resolving, connecting, the TLS handshake and the transfer,
+    // and returns TIMEOUT. Cancelling the token returns CANCELLED and closes the connection
+    // right away. Neither verdict is cached or stored.
+    ValidationType verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata, Deadline deadline);
+    ValidationType verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata, Deadline deadline,
+        const CancellationToken& cancellation);
+
+    std::future<ValidationType> verifyAsync(const std::string& licenseKey);
+    std::future<ValidationType> verifyAsync(const std::string& licenseKey, const std::string& scope);
+    std::future<ValidationType> verifyAsync(const std::string& licenseKey, const std::string& scope, const std::string& metadata);
+    void verifyAsync(const std::string& licenseKey, VerifyCallback callback);
+    void verifyAsync(const std::string& licenseKey, const std::string& scope, VerifyCallback callback);
+    void verifyAsync(const std::string& licenseKey, const std::string& scope, const std::string& metadata, VerifyCallback callback);
+
+    std::vector<ValidationType> verifyBatch(const std::vector<BatchRequest>& requests);
+
+    // Refreshes happen up to 10% before the interval is up, at most setBatchConcurrency() at a
+    // time, and bypass the verdict cache. If a refresh cannot reach the server, the last
+    // verdict is kept for up to three intervals. Watching a license twice returns the first watch.
+    WatchedLicense watch(const std::string& licenseKey, const std::string& scope, std::chrono::seconds interval);
+    WatchedLicense watch(const std::string& licenseKey, const std::string& scope, std::chrono::seconds interval, VerdictChangeCallback onChange);
+    bool unwatch(const std::string& licenseKey, const std::string& scope);
+    size_t watchedCount() const;
+
     bool verifySimple(const std::string& licenseKey);
     bool verifySimple(const std::string& licenseKey, const std::string& scope);
     bool verifySimple(const std::string& licenseKey, const std::string& scope, const std::string& metadata);
 
+    VerdictCache::Stats cacheStats() const;
+    EndpointSelector::Stats endpointStats() const;
+    RateLimiter::Stats rateLimitStats() const;
+    Logger::Stats logStats() const;
+    void clearCache();
+
+    // Latency per phase of every verification and the number of each result, since construction.
+    Metrics::Stats stats() const;
+    std::string prometheusMetrics() const;
+
     void exitApplication(const std::string& exitMessage);
 
 private:
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* response);
-    std::string buildUrl(const std::string& licenseKey, const std::string& scope, const std::string& metadata, const std::string& challenge);
-    json requestServer(const std::string& urlStr);
-    bool verifyChallenge(const std::string& challenge, const std::string& signedChallengeBase64);
-    ValidationType getValidationType(const std::string& result);
-    std::vector<unsigned char> base64_decode(const std::string& input);
+    struct Response {
+        ResponseParser parser;
+        std::string body; // only kept for responses the logger samples
+        bool keepBody = false;
+        std::chrono::nanoseconds parseTime{ 0 };
+    };
+
+    // What a bounded verify may spend; an unbounded one leaves both unset.
+    struct Limits {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        const CancellationToken* cancellation = nullptr;
+
+        bool bounded() const { return cancellation || deadline != std::chrono::steady_clock::time_point::max(); }
+        // Sets TIMEOUT or CANCELLED once the deadline has passed or the token is cancelled.
+        bool exceeded(std::chrono::steady_clock::time_point now, ValidationType& result) const;
+    };
+
+    // Constant unless the policy is Runtime, so that what a policy turns off compiles away.
+    static bool challengesOn(const Config& config) { return LicenseGatePolicy::active<ChallengePolicy>(config.useChallenges); }
+    static Logger* loggerOf(const Config& config) { return LicenseGatePolicy::compiled<DebugPolicy>() ? config.logger.get() : nullptr; }
+    static VerdictCache* cacheOf(const Config& config) { return LicenseGatePolicy::compiled<CachePolicy>() ? config.verdictCache.get() : nullptr; }
+
+    // Null unless the logger keeps records of this level, so that the arguments of a record
+    // are only computed when it is logged.
+    static Logger* logAt(const Config& config, Logger::Level level) {
+        Logger* logger = loggerOf(config);
+        return logger && logger->enabled(level) ? logger : nullptr;
+    }
+
+    Config initialConfig() const;
+    const Config& currentConfig() const;
+    void publishConfig(Config next);
+    BasicLicenseGate& updateConfig(const std::function<void(Config&)>& update);
+    // Null options keep the current ones, read under the same lock that publishes the servers.
+    BasicLicenseGate& replaceEndpoints(const std::vector<std::string>& servers, const EndpointSelector::Options* options);
+
+    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, Response* response);
+    static int PrewarmProgressCallback(void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+    void startPrewarm();
+    const std::string& buildUrl(const Config& config, size_t endpoint, const std::string& licenseKey, const std::string& scope, const std::string& metadata, const std::string& challenge);
+    std::string createChallenge(const Config& config);
+    AsyncEngine& getAsyncEngine();
+    RefreshScheduler& getRefreshScheduler();
+    void refreshWatch(RefreshScheduler& scheduler, const std::shared_ptr<RefreshScheduler::Watch>& watch);
+    ValidationType verifyWithin(const std::string& licenseKey, const std::string& scope, const std::string& metadata, const Limits& limits);
+    bool sleepWithin(const Limits& limits, std::chrono::steady_clock::duration wait, ValidationType& result);
+    void submitVerification(const std::string& licenseKey, const std::string& scope, const std::string& metadata, bool answerFromLocal, VerifyCallback callback);
+    ValidationType recordResult(ValidationType result, std::chrono::steady_clock::time_point start);
+    bool lookupCachedVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType& result);
+    bool admitRequest(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+        std::chrono::steady_clock::duration& wait, ValidationType& result);
+    bool answerLocally(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType& result);
+    bool lookupStoredVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+        std::chrono::seconds maxAge, ValidationType& result);
+    void storeVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType result,
+        const std::string& challenge, const std::string& signedChallenge);
+    void cacheVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType result);
+    void prepareRequest(const Config& config, CURL* curl, const std::string& urlStr, Response* response);
+    CURLcode requestServer(const Config& config, const std::string& urlStr, Response& response, const Limits& limits);
+    CURLcode performWithin(CURL* curl, const Limits& limits);
+    bool parseResponse(const Config& config, Response& response);
+    ValidationType evaluateResponse(const Config& config, const ResponseParser& response, const std::string& challenge);
+    ValidationType requestVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+        const std::string& challenge, std::string& signedChallenge, const Limits& limits);
+    ValidationType requestHedged(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+        const std::string& challenge, std::string& signedChallenge, const Limits& limits);
+    void recordEndpoint(const Config& config, size_t endpoint, std::chrono::steady_clock::time_point start, ValidationType result);
+    ValidationType readResponse(const Config& config, const std::string& challenge, Response* response, std::string& signedChallenge);
+    ValidationType finishVerification(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+        ValidationType result, const std::string& challenge, const std::string& signedChallenge);
+    ValidationType completeVerification(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+        const std::string& challenge, Response* response);
+    bool verifyChallenge(const Config& config, const std::string& challenge, std::string_view signedChallengeBase64);
+    ValidationType getValidationType(std::string_view result);
 };
 
+extern template class BasicLicenseGate<LicenseGatePolicy::Runtime, LicenseGatePolicy::Runtime, LicenseGatePolicy::Runtime>;
+using LicenseGate = BasicLicenseGate<>;
+
 #endif // LICENSE_GATE_H
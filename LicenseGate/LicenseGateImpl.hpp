@@ -0,0 +1,1269 @@
+#ifndef LICENSE_GATE_IMPL_H
+#define LICENSE_GATE_IMPL_H
+
+#include "LicenseGate.hpp"
+#include "XorStr.hpp"
+#include <limits>
+#include <optional>
+
+namespace LicenseGateDetail {
+
+    // Perfect hash over the result codes the server sends. The slots are computed at compile
+    // time, so the names below never reach the binary; a match is confirmed against the
+    // decrypted string table. FAILED_CHALLENGE and SERVER_ERROR have names but are only ever
+    // decided by the client, so a server that sends them gets SERVER_ERROR like any other
+    // unknown result.
+    inline constexpr size_t resultSlotCount = 16;
+    inline constexpr size_t resultCodeCount = 9;
+    inline constexpr size_t serverResultCount = 7;
+
+    constexpr size_t resultSlot(size_t length, char first) {
+        return (length + static_cast<unsigned char>(first)) & (resultSlotCount - 1);
+    }
+
+    struct ResultSlots {
+        int8_t codes[resultSlotCount] = {};
+        bool perfect = true;
+    };
+
+    constexpr ResultSlots buildResultSlots() {
+        const char* names[serverResultCount] = { "VALID", "NOT_FOUND", "NOT_ACTIVE", "EXPIRED", "LICENSE_SCOPE_FAILED",
+            "IP_LIMIT_EXCEEDED", "RATE_LIMIT_EXCEEDED" };
+        ResultSlots slots;
+        for (size_t slot = 0; slot < resultSlotCount; ++slot) slots.codes[slot] = -1;
+        for (size_t code = 0; code < serverResultCount; ++code) {
+            size_t length = 0;
+            while (names[code][length] != '\0') ++length;
+            size_t slot = resultSlot(length, names[code][0]);
+            if (slots.codes[slot] >= 0) slots.perfect = false;
+            slots.codes[slot] = static_cast<int8_t>(code);
+        }
+        return slots;
+    }
+
+    inline constexpr ResultSlots resultSlots = buildResultSlots();
+    static_assert(resultSlots.perfect, "result codes collide, adjust resultSlot()");
+    static_assert(static_cast<size_t>(LicenseGateBase::ValidationType::RATE_LIMIT_EXCEEDED) + 1 == serverResultCount,
+        "the server's result codes must come first in ValidationType");
+    static_assert(static_cast<size_t>(StringTable::Literal::ResultServerError) - static_cast<size_t>(StringTable::Literal::ResultValid) + 1
+        == resultCodeCount, "StringTable result literals must follow ValidationType");
+
+    inline std::string_view literal(StringTable::Literal literal) {
+        return StringTable::get(literal);
+    }
+
+    inline StringTable::Literal resultLiteral(size_t code) {
+        return static_cast<StringTable::Literal>(static_cast<size_t>(StringTable::Literal::ResultValid) + code);
+    }
+
+    // Indexed by ValidationType.
+    inline std::vector<std::string> validationTypeNames() {
+        std::vector<std::string> names;
+        for (size_t code = 0; code < resultCodeCount; ++code) names.emplace_back(literal(resultLiteral(code)));
+        names.emplace_back(xorstr_("CONNECTION_ERROR"));
+        names.emplace_back(xorstr_("TIMEOUT"));
+        names.emplace_back(xorstr_("CANCELLED"));
+        return names;
+    }
+
+    // One per thread, so connections to every endpoint stay open between verifications.
+    inline CURLM* threadMulti() {
+        struct MultiHandle {
+            CURLM* handle = curl_multi_init();
+            ~MultiHandle() { curl_multi_cleanup(handle); }
+        };
+        thread_local MultiHandle multi;
+        return multi.handle;
+    }
+
+    // Curl counts the timeout from the start of the transfer, so it covers resolving,
+    // connecting, the TLS handshake and the transfer itself.
+    inline void limitTransfer(CURL* curl, std::chrono::steady_clock::time_point deadline) {
+        if (deadline == std::chrono::steady_clock::time_point::max()) return;
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count() + 1;
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(std::max<int64_t>(1, std::min<int64_t>(remaining, std::numeric_limits<long>::max()))));
+    }
+
+    // How long to poll a multi handle: until the deadline, but at most a second.
+    inline int pollTimeout(std::chrono::steady_clock::time_point deadline, int timeoutMs) {
+        if (deadline == std::chrono::steady_clock::time_point::max()) return timeoutMs;
+        auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count() + 1;
+        return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(timeoutMs, untilDeadline)));
+    }
+
+    inline std::string sanitizeExitMessage(const std::string& message) {
+        std::string sanitizedMessage;
+        // Copy only alphanumeric characters and spaces to sanitizedMessage
+        std::copy_if(message.begin(), message.end(), std::back_inserter(sanitizedMessage), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || std::isspace(static_cast<unsigned char>(c));
+            });
+        return sanitizedMessage;
+    }
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::BasicLicenseGate(std::string userId) : userId(std::move(userId)), metrics(LicenseGateDetail::validationTypeNames()) {
+    publishConfig(initialConfig());
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::BasicLicenseGate(std::string userId, std::string publicRsaKey) : userId(std::move(userId)), metrics(LicenseGateDetail::validationTypeNames()) {
+    Config initial = initialConfig();
+    initial.useChallenges = true;
+    keyRing.add(initial.activeKeyId, publicRsaKey);
+    publishConfig(std::move(initial));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::~BasicLicenseGate() {
+    prewarmCancelled.store(true, std::memory_order_relaxed);
+
+    // Refreshes must stop before the engine that runs them; the scheduler itself outlives the
+    // engine, whose shutdown still completes the refreshes in flight.
+    std::lock_guard<std::mutex> lock(refreshSchedulerMutex);
+    if (refreshScheduler) refreshScheduler->stop();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+typename BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::Config BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::initialConfig() const {
+    Config initial;
+    initial.activeKeyId = userId;
+    // Enabled features start out with their default options.
+    if (std::is_same<DebugPolicy, LicenseGatePolicy::Enabled>::value) initial.logger.reset(new Logger(Logger::Options()));
+    if (std::is_same<CachePolicy, LicenseGatePolicy::Enabled>::value) initial.verdictCache.reset(new VerdictCache(VerdictCache::Options()));
+    return initial;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+const typename BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::Config& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::currentConfig() const {
+    return *config.load(std::memory_order_acquire);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::publishConfig(Config next) {
+    configs.emplace_back(new Config(std::move(next)));
+    config.store(configs.back().get(), std::memory_order_release);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::updateConfig(const std::function<void(Config&)>& update) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    Config next = currentConfig();
+    update(next);
+    publishConfig(std::move(next));
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setPublicRsaKey(const std::string& publicKey) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    keyRing.replaceAll(currentConfig().activeKeyId, publicKey);
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::addPublicRsaKey(const std::string& keyId, const std::string& publicKey) {
+    return addPublicRsaKey(keyId, publicKey, std::string());
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::addPublicRsaKey(const std::string& keyId, const std::string& publicKey,
+    const std::string& rotationGroup) {
+    if (keyRing.add(keyId, publicKey, rotationGroup)) return *this;
+    if (Logger* log = logAt(currentConfig(), Logger::Level::Error))
+        log->log(Logger::Level::Error, xorstr_("Error reading public key: %s"), ERR_error_string(ERR_get_error(), NULL));
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::removePublicRsaKey(const std::string& keyId) {
+    keyRing.remove(keyId);
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setActiveKeyId(const std::string& keyId) {
+    return updateConfig([&](Config& next) { next.activeKeyId = keyId; });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setValidationServer(const std::string& server) {
+    return replaceEndpoints({ server }, nullptr);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setValidationServers(const std::vector<std::string>& servers) {
+    return replaceEndpoints(servers, nullptr);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setValidationServers(const std::vector<std::string>& servers, const EndpointSelector::Options& options) {
+    return replaceEndpoints(servers, &options);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::replaceEndpoints(const std::vector<std::string>& servers, const EndpointSelector::Options* options) {
+    if (servers.empty()) throw std::runtime_error(xorstr_("At least one validation server is required"));
+    updateConfig([&](Config& next) {
+        next.endpoints = std::make_shared<EndpointSelector>(servers, options ? *options : next.endpoints->getOptions());
+    });
+    if (currentConfig().prewarm) startPrewarm();
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableChallenges() {
+    return updateConfig([](Config& next) { next.useChallenges = true; });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableDebug() {
+    return enableDebug(Logger::Options());
+}
+
+// Retired snapshots keep a replaced logger running, so records logged through them still arrive.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableDebug(const Logger::Options& options) {
+    if (!LicenseGatePolicy::compiled<DebugPolicy>()) return *this;
+    std::shared_ptr<Logger> logger(new Logger(options));
+    return updateConfig([&](Config& next) { next.logger = logger; });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setConnectionPoolSize(size_t poolSize) {
+    connectionPool.setPoolSize(poolSize);
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setConnectionIdleTimeout(long seconds) {
+    connectionPool.setIdleTimeout(seconds);
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setConnectionMaxAge(long seconds) {
+    connectionPool.setMaxConnectionAge(seconds);
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableCache() {
+    return enableCache(VerdictCache::Options());
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableCache(const VerdictCache::Options& options) {
+    if (!LicenseGatePolicy::compiled<CachePolicy>()) return *this;
+    std::shared_ptr<VerdictCache> cache(new VerdictCache(options));
+    std::shared_ptr<VerdictCache> replaced;
+    updateConfig([&](Config& next) {
+        replaced = next.verdictCache;
+        next.verdictCache = cache;
+    });
+    // Retired snapshots keep the old cache alive, so release its entries now.
+    if (replaced) replaced->clear();
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+VerdictCache::Stats BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::cacheStats() const {
+    VerdictCache* cache = cacheOf(currentConfig());
+    return cache ? cache->stats() : VerdictCache::Stats();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+EndpointSelector::Stats BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::endpointStats() const {
+    return currentConfig().endpoints->stats();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+RateLimiter::Stats BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::rateLimitStats() const {
+    const Config& config = currentConfig();
+    return config.rateLimiter ? config.rateLimiter->stats() : RateLimiter::Stats();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+Logger::Stats BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::logStats() const {
+    Logger* logger = loggerOf(currentConfig());
+    return logger ? logger->stats() : Logger::Stats();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::clearCache() {
+    if (VerdictCache* cache = cacheOf(currentConfig())) cache->clear();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+Metrics::Stats BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::stats() const {
+    return metrics.stats();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+std::string BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::prometheusMetrics() const {
+    return metrics.prometheus();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableVerdictStore(const VerdictStore::Options& options) {
+    std::shared_ptr<VerdictStore> store(new VerdictStore(options));
+    if (!store->isOpen()) {
+        if (Logger* log = logAt(currentConfig(), Logger::Level::Error))
+            log->log(Logger::Level::Error, xorstr_("Error opening verdict store: %s"), options.path.c_str());
+        store.reset();
+    }
+    return updateConfig([&](Config& next) { next.verdictStore = store; });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableTlsSessionCache(const std::string& path) {
+    // Retired snapshots keep a replaced store alive for connections that still use it.
+    std::shared_ptr<TlsSessionStore> store(new TlsSessionStore(path));
+    updateConfig([&](Config& next) { next.tlsSessions = store; });
+    if (connectionPool.setTlsSessionStore(store)) return *this;
+    if (Logger* log = logAt(currentConfig(), Logger::Level::Warning))
+        log->log(Logger::Level::Warning, xorstr_("TLS session cache needs libcurl built with OpenSSL"));
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enableRateLimit(const RateLimiter::Options& options) {
+    if (!(options.requestsPerSecond > 0) || !(options.burst >= 1)) throw std::runtime_error(xorstr_("The rate limit must allow at least one request"));
+    std::shared_ptr<RateLimiter> limiter = RateLimiter::forUser(userId, options);
+    return updateConfig([&](Config& next) { next.rateLimiter = limiter; });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::enablePrewarm() {
+    updateConfig([](Config& next) { next.prewarm = true; });
+    startPrewarm();
+    return *this;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::startPrewarm() {
+    std::lock_guard<std::mutex> lock(prewarmMutex);
+    prewarms.erase(std::remove_if(prewarms.begin(), prewarms.end(), [](const std::future<void>& prewarm) {
+        return prewarm.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), prewarms.end());
+    prewarms.push_back(std::async(std::launch::async, [this]() { prewarm(); }));
+}
+
+// The connection is made by a HEAD request for the server's root on a pooled handle. Returning
+// the handle to the pool keeps the connection open on it, and since the pool hands out the
+// handle returned last, the next verification uses it. One handle holds a connection to
+// every server, so it does not matter which server that verification picks.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::prewarm() {
+    const Config& config = currentConfig();
+    StringTable::get(StringTable::Literal::ResultValid);
+    Base64::vectorized();
+
+    ConnectionPool::Lease curl(connectionPool);
+    if (!curl) return;
+    for (size_t endpoint = 0; endpoint < config.endpoints->size() && !prewarmCancelled.load(std::memory_order_relaxed); ++endpoint) {
+        curl_easy_setopt(curl.get(), CURLOPT_URL, config.endpoints->url(endpoint).c_str());
+        curl_easy_setopt(curl.get(), CURLOPT_NOBODY, 1L);
+        curl_easy_setopt(curl.get(), CURLOPT_CONNECTTIMEOUT, 5L);
+        curl_easy_setopt(curl.get(), CURLOPT_TIMEOUT, 10L);
+        curl_easy_setopt(curl.get(), CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl.get(), CURLOPT_XFERINFOFUNCTION, PrewarmProgressCallback);
+        curl_easy_setopt(curl.get(), CURLOPT_XFERINFODATA, this);
+        CURLcode res = curl_easy_perform(curl.get());
+        if (res == CURLE_OK || res == CURLE_ABORTED_BY_CALLBACK) continue;
+        if (Logger* log = logAt(config, Logger::Level::Warning))
+            log->log(Logger::Level::Warning, xorstr_("Prewarm failed for %s: %s"), config.endpoints->url(endpoint).c_str(), curl_easy_strerror(res));
+    }
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+int BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::PrewarmProgressCallback(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<BasicLicenseGate*>(clientp)->prewarmCancelled.load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::setBatchConcurrency(size_t maxInFlight) {
+    return updateConfig([&](Config& next) { next.batchConcurrency = maxInFlight > 0 ? maxInFlight : 1; });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verify(const std::string& licenseKey) {
+    return verify(licenseKey, "", "");
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verify(const std::string& licenseKey, const std::string& scope) {
+    return verify(licenseKey, scope, "");
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+    return verifyWithin(licenseKey, scope, metadata, Limits());
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata, Deadline deadline) {
+    Limits limits;
+    limits.deadline = deadline;
+    return verifyWithin(licenseKey, scope, metadata, limits);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata, Deadline deadline,
+    const CancellationToken& cancellation) {
+    Limits limits;
+    limits.deadline = deadline;
+    limits.cancellation = &cancellation;
+    return verifyWithin(licenseKey, scope, metadata, limits);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::Limits::exceeded(std::chrono::steady_clock::time_point now, ValidationType& result) const {
+    if (cancellation && cancellation->cancelled()) result = ValidationType::CANCELLED;
+    else if (now >= deadline) result = ValidationType::TIMEOUT;
+    else return false;
+    return true;
+}
+
+// A bounded verify that runs out leaves the coalesced request as abandoned, so that callers
+// waiting on it with limits of their own, or none, send their own request.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyWithin(const std::string& licenseKey, const std::string& scope, const std::string& metadata, const Limits& limits) {
+    auto start = std::chrono::steady_clock::now();
+    const Config& config = currentConfig();
+    ValidationType result;
+    if (answerLocally(config, licenseKey, scope, metadata, result)) return recordResult(result, start);
+    if (limits.exceeded(start, result)) return recordResult(result, start);
+
+    RequestCoalescer::Bounds bounds;
+    bounds.deadline = limits.deadline;
+    bounds.cancellation = limits.cancellation;
+    bounds.expiredResult = static_cast<int>(ValidationType::TIMEOUT);
+    bounds.cancelledResult = static_cast<int>(ValidationType::CANCELLED);
+    result = static_cast<ValidationType>(requestCoalescer.run(licenseKey, scope, metadata, bounds, [&]() {
+        std::chrono::steady_clock::duration wait;
+        ValidationType verdict;
+        if (!admitRequest(config, licenseKey, scope, metadata, wait, verdict)) return static_cast<int>(verdict);
+        if (wait.count() > 0 && !sleepWithin(limits, wait, verdict)) throw RequestCoalescer::Abandoned{ static_cast<int>(verdict) };
+
+        std::string challenge;
+        std::string signedChallenge;
+        verdict = ValidationType::CONNECTION_ERROR;
+        try {
+            challenge = createChallenge(config);
+            verdict = requestVerdict(config, licenseKey, scope, metadata, challenge, signedChallenge, limits);
+        }
+        catch (...) {}
+        if (verdict == ValidationType::TIMEOUT || verdict == ValidationType::CANCELLED) throw RequestCoalescer::Abandoned{ static_cast<int>(verdict) };
+
+        return static_cast<int>(finishVerification(config, licenseKey, scope, metadata, verdict, challenge, signedChallenge));
+    }));
+    return recordResult(result, start);
+}
+
+// Waits out the rate limiter. A slot that only opens after the deadline is not worth waiting for.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::sleepWithin(const Limits& limits, std::chrono::steady_clock::duration wait, ValidationType& result) {
+    auto until = std::chrono::steady_clock::now() + wait;
+    if (until > limits.deadline) {
+        result = ValidationType::TIMEOUT;
+        return false;
+    }
+    if (!limits.cancellation) {
+        std::this_thread::sleep_until(until);
+        return true;
+    }
+    if (limits.cancellation->sleepUntil(until)) return true;
+    result = ValidationType::CANCELLED;
+    return false;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+std::future<LicenseGateBase::ValidationType> BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyAsync(const std::string& licenseKey) {
+    return verifyAsync(licenseKey, "", "");
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+std::future<LicenseGateBase::ValidationType> BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyAsync(const std::string& licenseKey, const std::string& scope) {
+    return verifyAsync(licenseKey, scope, "");
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+std::future<LicenseGateBase::ValidationType> BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyAsync(const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+    auto promise = std::make_shared<std::promise<ValidationType>>();
+    std::future<ValidationType> future = promise->get_future();
+    verifyAsync(licenseKey, scope, metadata, [promise](ValidationType result) { promise->set_value(result); });
+    return future;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyAsync(const std::string& licenseKey, VerifyCallback callback) {
+    verifyAsync(licenseKey, "", "", std::move(callback));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyAsync(const std::string& licenseKey, const std::string& scope, VerifyCallback callback) {
+    verifyAsync(licenseKey, scope, "", std::move(callback));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyAsync(const std::string& licenseKey, const std::string& scope, const std::string& metadata, VerifyCallback callback) {
+    submitVerification(licenseKey, scope, metadata, true, std::move(callback));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::submitVerification(const std::string& licenseKey, const std::string& scope, const std::string& metadata, bool answerFromLocal,
+    VerifyCallback callback) {
+    struct Transfer {
+        CURL* curl = nullptr;
+        std::string licenseKey;
+        std::string scope;
+        std::string metadata;
+        std::string challenge;
+        size_t endpoint = 0;
+        std::chrono::steady_clock::time_point start;
+        Response response;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    VerifyCallback report = [this, start, callback](ValidationType result) { callback(recordResult(result, start)); };
+
+    const Config& config = currentConfig();
+    ValidationType local;
+    if (answerFromLocal && answerLocally(config, licenseKey, scope, metadata, local)) {
+        report(local);
+        return;
+    }
+    std::chrono::steady_clock::duration wait;
+    if (!admitRequest(config, licenseKey, scope, metadata, wait, local)) {
+        report(local);
+        return;
+    }
+
+    auto transfer = std::make_shared<Transfer>();
+    try {
+        transfer->licenseKey = licenseKey;
+        transfer->scope = scope;
+        transfer->metadata = metadata;
+        transfer->challenge = createChallenge(config);
+        transfer->endpoint = config.endpoints->pick();
+        const std::string& url = buildUrl(config, transfer->endpoint, licenseKey, scope, metadata, transfer->challenge);
+        AsyncEngine& engine = getAsyncEngine();
+
+        transfer->curl = connectionPool.acquire();
+        if (!transfer->curl) throw std::runtime_error(xorstr_("Failed to initialize CURL"));
+        prepareRequest(config, transfer->curl, url, &transfer->response);
+        transfer->start = std::chrono::steady_clock::now() + wait;
+
+        bool submitted = engine.submit(transfer->curl, [this, &config, transfer, report](CURLcode res) {
+            if (res == CURLE_OK) metrics.recordTransfer(transfer->curl);
+            connectionPool.release(transfer->curl);
+
+            std::string signedChallenge;
+            ValidationType result = readResponse(config, transfer->challenge, res == CURLE_OK ? &transfer->response : nullptr, signedChallenge);
+            if (res != CURLE_ABORTED_BY_CALLBACK) recordEndpoint(config, transfer->endpoint, transfer->start, result);
+            report(finishVerification(config, transfer->licenseKey, transfer->scope, transfer->metadata, result, transfer->challenge, signedChallenge));
+        }, transfer->start);
+        if (submitted) return;
+
+        connectionPool.release(transfer->curl);
+    }
+    catch (...) {
+        if (transfer->curl) connectionPool.release(transfer->curl);
+    }
+    report(completeVerification(config, licenseKey, scope, metadata, transfer->challenge, nullptr));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::WatchedLicense BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::watch(const std::string& licenseKey, const std::string& scope, std::chrono::seconds interval) {
+    return watch(licenseKey, scope, interval, nullptr);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::WatchedLicense BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::watch(const std::string& licenseKey, const std::string& scope, std::chrono::seconds interval,
+    VerdictChangeCallback onChange) {
+    RefreshScheduler::OnChange notify;
+    if (onChange) {
+        notify = [onChange](int previous, int current) {
+            onChange(static_cast<ValidationType>(previous), static_cast<ValidationType>(current));
+        };
+    }
+    return WatchedLicense(getRefreshScheduler().watch(licenseKey, scope, interval, std::move(notify)));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::unwatch(const std::string& licenseKey, const std::string& scope) {
+    std::lock_guard<std::mutex> lock(refreshSchedulerMutex);
+    return refreshScheduler && refreshScheduler->unwatch(licenseKey, scope);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+size_t BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::watchedCount() const {
+    std::lock_guard<std::mutex> lock(refreshSchedulerMutex);
+    return refreshScheduler ? refreshScheduler->size() : 0;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+RefreshScheduler& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::getRefreshScheduler() {
+    std::lock_guard<std::mutex> lock(refreshSchedulerMutex);
+    if (!refreshScheduler) {
+        refreshScheduler.reset(new RefreshScheduler(
+            [this](RefreshScheduler& scheduler, const std::shared_ptr<RefreshScheduler::Watch>& watch) { refreshWatch(scheduler, watch); },
+            currentConfig().batchConcurrency, static_cast<int>(ValidationType::CONNECTION_ERROR)));
+    }
+    return *refreshScheduler;
+}
+
+// The scheduler outlives every refresh: the destructor stops it first and destroys it only
+// after the async engine has completed whatever was still in flight.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::refreshWatch(RefreshScheduler& scheduler, const std::shared_ptr<RefreshScheduler::Watch>& watch) {
+    RefreshScheduler* target = &scheduler;
+    submitVerification(watch->licenseKey, watch->scope, "", false, [target, watch](ValidationType result) {
+        bool transient = result == ValidationType::CONNECTION_ERROR || result == ValidationType::SERVER_ERROR
+            || result == ValidationType::RATE_LIMIT_EXCEEDED;
+        target->complete(watch, static_cast<int>(result), transient);
+    });
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+std::vector<LicenseGateBase::ValidationType> BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyBatch(const std::vector<BatchRequest>& requests) {
+    struct Transfer {
+        CURL* curl = nullptr;
+        size_t index = 0;
+        size_t endpoint = 0;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point sent;
+        std::string challenge;
+        Response response;
+    };
+
+    std::vector<ValidationType> results(requests.size(), ValidationType::CONNECTION_ERROR);
+    if (requests.empty()) return results;
+
+    const Config& config = currentConfig();
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) return results;
+
+    std::vector<Transfer> transfers(std::min(config.batchConcurrency, requests.size()));
+    std::vector<Transfer*> freeTransfers;
+    for (Transfer& transfer : transfers) freeTransfers.push_back(&transfer);
+
+    // Transfers the rate limiter has admitted for later, in the order they are due.
+    std::deque<Transfer*> held;
+    auto fail = [&](Transfer* transfer) {
+        const BatchRequest& request = requests[transfer->index];
+        results[transfer->index] = recordResult(
+            completeVerification(config, request.licenseKey, request.scope, request.metadata, transfer->challenge, nullptr), transfer->start);
+    };
+
+    size_t next = 0;
+    int running = 0;
+    while (next < requests.size() || running > 0 || !held.empty()) {
+        while (next < requests.size() && !freeTransfers.empty()) {
+            Transfer* transfer = freeTransfers.back();
+            transfer->index = next++;
+            transfer->start = std::chrono::steady_clock::now();
+
+            const BatchRequest& request = requests[transfer->index];
+            if (answerLocally(config, request.licenseKey, request.scope, request.metadata, results[transfer->index])) {
+                recordResult(results[transfer->index], transfer->start);
+                continue;
+            }
+            std::chrono::steady_clock::duration wait;
+            if (!admitRequest(config, request.licenseKey, request.scope, request.metadata, wait, results[transfer->index])) {
+                recordResult(results[transfer->index], transfer->start);
+                continue;
+            }
+
+            bool started = false;
+            try {
+                transfer->challenge = createChallenge(config);
+                transfer->endpoint = config.endpoints->pick();
+                const std::string& url = buildUrl(config, transfer->endpoint, request.licenseKey, request.scope, request.metadata, transfer->challenge);
+
+                transfer->curl = connectionPool.acquire();
+                if (transfer->curl) {
+                    prepareRequest(config, transfer->curl, url, &transfer->response);
+                    curl_easy_setopt(transfer->curl, CURLOPT_PRIVATE, transfer);
+                    transfer->sent = std::chrono::steady_clock::now() + wait;
+                    if (wait.count() > 0) {
+                        held.push_back(transfer);
+                        started = true;
+                    }
+                    else {
+                        started = curl_multi_add_handle(multi, transfer->curl) == CURLM_OK;
+                        if (!started) connectionPool.release(transfer->curl);
+                    }
+                }
+            }
+            catch (...) {}
+
+            if (!started) {
+                fail(transfer);
+                continue;
+            }
+            freeTransfers.pop_back();
+        }
+
+        for (auto now = std::chrono::steady_clock::now(); !held.empty() && held.front()->sent <= now; held.pop_front()) {
+            Transfer* transfer = held.front();
+            if (curl_multi_add_handle(multi, transfer->curl) == CURLM_OK) continue;
+            connectionPool.release(transfer->curl);
+            transfer->curl = nullptr;
+            fail(transfer);
+            freeTransfers.push_back(transfer);
+        }
+
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            CURLcode res = message->data.result;
+            if (res == CURLE_OK) metrics.recordTransfer(transfer->curl);
+            curl_multi_remove_handle(multi, transfer->curl);
+            connectionPool.release(transfer->curl);
+            transfer->curl = nullptr;
+
+            const BatchRequest& request = requests[transfer->index];
+            std::string signedChallenge;
+            ValidationType result = readResponse(config, transfer->challenge, res == CURLE_OK ? &transfer->response : nullptr, signedChallenge);
+            recordEndpoint(config, transfer->endpoint, transfer->sent, result);
+            results[transfer->index] = recordResult(finishVerification(config, request.licenseKey, request.scope, request.metadata,
+                result, transfer->challenge, signedChallenge), transfer->start);
+            freeTransfers.push_back(transfer);
+        }
+
+        int timeoutMs = 1000;
+        if (!held.empty()) {
+            auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(held.front()->sent - std::chrono::steady_clock::now()).count() + 1;
+            timeoutMs = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(timeoutMs, untilDue)));
+        }
+        if (running > 0 || !held.empty()) curl_multi_poll(multi, NULL, 0, timeoutMs, NULL);
+    }
+
+    curl_multi_cleanup(multi);
+    return results;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::requestVerdict(const Config& config, const std::string& licenseKey, const std::string& scope,
+    const std::string& metadata, const std::string& challenge, std::string& signedChallenge, const Limits& limits) {
+    EndpointSelector& endpoints = *config.endpoints;
+    if (endpoints.getOptions().hedge && endpoints.size() > 1) return requestHedged(config, licenseKey, scope, metadata, challenge, signedChallenge, limits);
+
+    size_t endpoint = endpoints.pick();
+    auto start = std::chrono::steady_clock::now();
+    Response response;
+    CURLcode res = CURLE_FAILED_INIT;
+    try {
+        res = requestServer(config, buildUrl(config, endpoint, licenseKey, scope, metadata, challenge), response, limits);
+    }
+    catch (...) {}
+
+    // The caller's limits say nothing about the endpoint, so running out of them is not held against it.
+    if (limits.bounded() && res == CURLE_OPERATION_TIMEDOUT) return ValidationType::TIMEOUT;
+    if (limits.bounded() && res == CURLE_ABORTED_BY_CALLBACK) return ValidationType::CANCELLED;
+    ValidationType result = readResponse(config, challenge, res == CURLE_OK ? &response : nullptr, signedChallenge);
+    recordEndpoint(config, endpoint, start, result);
+    return result;
+}
+
+// Sends the request to the preferred endpoint and, if no answer has come back within the
+// hedge delay or the first attempt fails, to a second one. The first answer that is a real
+// verdict wins and the other transfer is abandoned.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::requestHedged(const Config& config, const std::string& licenseKey, const std::string& scope,
+    const std::string& metadata, const std::string& challenge, std::string& signedChallenge, const Limits& limits) {
+    struct Attempt {
+        size_t endpoint = EndpointSelector::none;
+        CURL* curl = nullptr;
+        std::chrono::steady_clock::time_point start;
+        Response response;
+    };
+
+    CURLM* multi = LicenseGateDetail::threadMulti();
+    if (!multi) throw std::runtime_error(xorstr_("Failed to initialize CURL"));
+    std::optional<CancellationToken::Listener> listener;
+    if (limits.cancellation) listener.emplace(*limits.cancellation, [multi]() { curl_multi_wakeup(multi); });
+
+    EndpointSelector& endpoints = *config.endpoints;
+    Attempt attempts[2];
+
+    auto launch = [&](Attempt& attempt, size_t endpoint) {
+        if (endpoint == EndpointSelector::none) return false;
+        // A second attempt is extra load on the account, so it only goes out if the limiter has room now.
+        if (&attempt == &attempts[1] && config.rateLimiter && !config.rateLimiter->tryAcquire(std::chrono::steady_clock::now())) return false;
+        attempt.endpoint = endpoint;
+        attempt.curl = connectionPool.acquire();
+        if (!attempt.curl) return false;
+
+        prepareRequest(config, attempt.curl, buildUrl(config, endpoint, licenseKey, scope, metadata, challenge), &attempt.response);
+        LicenseGateDetail::limitTransfer(attempt.curl, limits.deadline);
+        attempt.start = std::chrono::steady_clock::now();
+        if (curl_multi_add_handle(multi, attempt.curl) == CURLM_OK) return true;
+        connectionPool.release(attempt.curl);
+        attempt.curl = nullptr;
+        return false;
+    };
+    auto retire = [&](Attempt& attempt) {
+        curl_multi_remove_handle(multi, attempt.curl);
+        connectionPool.release(attempt.curl);
+        attempt.curl = nullptr;
+    };
+
+    ValidationType result = ValidationType::CONNECTION_ERROR;
+    std::chrono::nanoseconds hedgeDelay = endpoints.hedgeDelay();
+    bool secondStarted = false;
+    bool hedged = false;
+    bool expired = false;
+    int winner = -1;
+
+    if (!launch(attempts[0], endpoints.pick())) return result;
+    while (winner < 0 && (attempts[0].curl || attempts[1].curl)) {
+        if (limits.exceeded(std::chrono::steady_clock::now(), result)) {
+            expired = true;
+            break;
+        }
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            int index = message->easy_handle == attempts[0].curl ? 0 : 1;
+            Attempt& attempt = attempts[index];
+            CURLcode res = message->data.result;
+            if (res == CURLE_OK) metrics.recordTransfer(attempt.curl);
+            retire(attempt);
+            if (limits.bounded() && res == CURLE_OPERATION_TIMEDOUT) {
+                result = ValidationType::TIMEOUT;
+                expired = true;
+                break;
+            }
+
+            std::string signature;
+            ValidationType verdict = readResponse(config, challenge, res == CURLE_OK ? &attempt.response : nullptr, signature);
+            recordEndpoint(config, attempt.endpoint, attempt.start, verdict);
+            if (verdict != ValidationType::CONNECTION_ERROR && verdict != ValidationType::SERVER_ERROR && verdict != ValidationType::FAILED_CHALLENGE) {
+                result = verdict;
+                signedChallenge = std::move(signature);
+                winner = index;
+                break;
+            }
+            if (result == ValidationType::CONNECTION_ERROR) result = verdict;
+            if (!secondStarted) {
+                secondStarted = true;
+                launch(attempts[1], endpoints.pick(attempts[0].endpoint));
+            }
+        }
+        if (winner >= 0 || expired || (!attempts[0].curl && !attempts[1].curl)) break;
+
+        int timeoutMs = 1000;
+        if (!secondStarted && hedgeDelay.count() > 0) {
+            auto remaining = hedgeDelay - (std::chrono::steady_clock::now() - attempts[0].start);
+            if (remaining.count() <= 0) {
+                secondStarted = true;
+                hedged = launch(attempts[1], endpoints.pick(attempts[0].endpoint));
+                continue;
+            }
+            timeoutMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count()) + 1;
+        }
+        curl_multi_poll(multi, NULL, 0, LicenseGateDetail::pollTimeout(limits.deadline, timeoutMs), NULL);
+    }
+
+    // The loser never answered, so it counts neither for nor against its endpoint: a stalling
+    // endpoint must not have its breaker reset by every hedge it loses. Only the time it has
+    // taken so far is kept, as a lower bound on its latency.
+    for (Attempt& attempt : attempts) {
+        if (!attempt.curl) continue;
+        retire(attempt);
+        if (winner >= 0) config.endpoints->recordAbandoned(attempt.endpoint, std::chrono::steady_clock::now() - attempt.start);
+    }
+    if (hedged) endpoints.countHedge(winner == 1);
+    return result;
+}
+
+// Transfer failures, malformed answers and bad signatures count against the endpoint; any
+// verdict the server actually reached counts for it. Every answer also feeds the rate limiter.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::recordEndpoint(const Config& config, size_t endpoint, std::chrono::steady_clock::time_point start, ValidationType result) {
+    auto now = std::chrono::steady_clock::now();
+    bool success = result != ValidationType::CONNECTION_ERROR && result != ValidationType::SERVER_ERROR && result != ValidationType::FAILED_CHALLENGE;
+    config.endpoints->record(endpoint, now - start, success);
+    if (config.rateLimiter && result != ValidationType::CONNECTION_ERROR) config.rateLimiter->record(result == ValidationType::RATE_LIMIT_EXCEEDED, now);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::readResponse(const Config& config, const std::string& challenge, Response* response, std::string& signedChallenge) {
+    if (!response) return ValidationType::CONNECTION_ERROR;
+
+    auto start = std::chrono::steady_clock::now();
+    bool parsed = parseResponse(config, *response);
+    metrics.record(Metrics::Phase::Parse, response->parseTime + (std::chrono::steady_clock::now() - start));
+    if (!parsed) return ValidationType::CONNECTION_ERROR;
+
+    try {
+        const ResponseParser& fields = response->parser;
+        ValidationType result = evaluateResponse(config, fields, challenge);
+        if (config.verdictStore && fields.signedChallenge.isString() && !fields.signedChallenge.overflow)
+            signedChallenge.assign(fields.signedChallenge.value, fields.signedChallenge.length);
+        return result;
+    }
+    catch (...) {
+        return ValidationType::CONNECTION_ERROR;
+    }
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::finishVerification(const Config& config, const std::string& licenseKey, const std::string& scope,
+    const std::string& metadata, ValidationType result, const std::string& challenge, const std::string& signedChallenge) {
+    if (result == ValidationType::CONNECTION_ERROR) {
+        if (config.verdictStore) lookupStoredVerdict(config, licenseKey, scope, metadata, config.verdictStore->getOptions().maxOfflineAge, result);
+        return result;
+    }
+
+    cacheVerdict(config, licenseKey, scope, metadata, result);
+    storeVerdict(config, licenseKey, scope, metadata, result, challenge, signedChallenge);
+    return result;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::completeVerification(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+    const std::string& challenge, Response* response) {
+    std::string signedChallenge;
+    ValidationType result = readResponse(config, challenge, response, signedChallenge);
+    return finishVerification(config, licenseKey, scope, metadata, result, challenge, signedChallenge);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::evaluateResponse(const Config& config, const ResponseParser& response, const std::string& challenge) {
+    if (response.error.type != ResponseParser::ValueType::Missing || response.result.type == ResponseParser::ValueType::Missing) {
+        if (Logger* log = logAt(config, Logger::Level::Warning))
+            log->log(Logger::Level::Warning, xorstr_("Error: %.*s"),
+                static_cast<int>(std::min(response.error.length, sizeof(response.error.value))), response.error.value);
+        return ValidationType::SERVER_ERROR;
+    }
+
+    // Members of the wrong type count as CONNECTION_ERROR, as they did when json::get<>() threw.
+    if (response.valid.type != ResponseParser::ValueType::Missing) {
+        if (!response.valid.isBoolean()) return ValidationType::CONNECTION_ERROR;
+        if (response.valid.type == ResponseParser::ValueType::False) {
+            if (!response.result.isString()) return ValidationType::CONNECTION_ERROR;
+            ValidationType result = getValidationType(std::string_view(response.result.value, response.result.overflow ? 0 : response.result.length));
+            return result != ValidationType::VALID ? result : ValidationType::SERVER_ERROR;
+        }
+    }
+
+    if (challengesOn(config)) {
+        if (!response.signedChallenge.isString()) return ValidationType::CONNECTION_ERROR;
+        // A signature too long for the buffer cannot belong to any supported key.
+        if (response.signedChallenge.overflow
+            || !verifyChallenge(config, challenge, std::string_view(response.signedChallenge.value, response.signedChallenge.length))) {
+            if (Logger* log = logAt(config, Logger::Level::Warning)) log->log(Logger::Level::Warning, xorstr_("Error: Challenge verification failed"));
+            return ValidationType::FAILED_CHALLENGE;
+        }
+    }
+
+    if (!response.result.isString()) return ValidationType::CONNECTION_ERROR;
+    return getValidationType(std::string_view(response.result.value, response.result.overflow ? 0 : response.result.length));
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifySimple(const std::string& licenseKey) {
+    return verify(licenseKey) == ValidationType::VALID;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifySimple(const std::string& licenseKey, const std::string& scope) {
+    return verify(licenseKey, scope) == ValidationType::VALID;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifySimple(const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+    return verify(licenseKey, scope, metadata) == ValidationType::VALID;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::exitApplication(const std::string& exitMessage)
+{
+    system(("start cmd /C \"color 4 && title Error && echo " + LicenseGateDetail::sanitizeExitMessage(exitMessage) + " && timeout /t 5 > NUL\"").c_str());
+    exit(0);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+size_t BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::WriteCallback(void* contents, size_t size, size_t nmemb, Response* response) {
+    size_t totalSize = size * nmemb;
+    if (response->keepBody) response->body.append((char*)contents, totalSize);
+
+    auto start = std::chrono::steady_clock::now();
+    bool parsing = response->parser.feed((char*)contents, totalSize);
+    response->parseTime += std::chrono::steady_clock::now() - start;
+
+    // Once the body can no longer parse there is no point in receiving the rest of it.
+    if (!parsing && !response->keepBody) return 0;
+    return totalSize;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+const std::string& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::buildUrl(const Config& config, size_t endpoint, const std::string& licenseKey, const std::string& scope, const std::string& metadata, const std::string& challenge) {
+    using Literal = StringTable::Literal;
+    using LicenseGateDetail::literal;
+
+    // Reused by every call on this thread, so building a URL does not allocate once it has
+    // grown to size. Callers hand it to curl, which copies it, before building the next one.
+    thread_local std::string url;
+    url.clear();
+    url.append(config.endpoints->url(endpoint)).append(literal(Literal::LicensePath)).append(userId)
+        .append(literal(Literal::PathSeparator)).append(licenseKey).append(literal(Literal::VerifyPath));
+
+    bool first = true;
+    auto appendParameter = [&](Literal name, const std::string& value) {
+        url.append(literal(first ? Literal::QueryFirst : Literal::QueryNext)).append(literal(name));
+        UrlEncoder::append(url, value);
+        first = false;
+    };
+    if (!metadata.empty()) appendParameter(Literal::QueryMetadata, metadata);
+    if (!scope.empty()) appendParameter(Literal::QueryScope, scope);
+    if (challengesOn(config) && !challenge.empty()) appendParameter(Literal::QueryChallenge, challenge);
+
+    return url;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+std::string BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::createChallenge(const Config& config) {
+    return challengesOn(config) ? std::to_string(std::time(nullptr)) : "";
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::lookupCachedVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType& result) {
+    VerdictCache* cache = cacheOf(config);
+    int verdict;
+    if (!cache || !cache->lookup(userId, licenseKey, scope, metadata, verdict)) return false;
+    result = static_cast<ValidationType>(verdict);
+    return true;
+}
+
+// Over the limit, the answer is RATE_LIMIT_EXCEEDED or, when serving stale verdicts, whatever
+// the verdict store would answer while offline.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::admitRequest(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+    std::chrono::steady_clock::duration& wait, ValidationType& result) {
+    wait = std::chrono::steady_clock::duration::zero();
+    if (!config.rateLimiter || config.rateLimiter->acquire(std::chrono::steady_clock::now(), wait)) return true;
+
+    result = ValidationType::RATE_LIMIT_EXCEEDED;
+    if (config.rateLimiter->getOptions().overLimit == RateLimiter::OverLimit::ServeStale && config.verdictStore)
+        lookupStoredVerdict(config, licenseKey, scope, metadata, config.verdictStore->getOptions().maxOfflineAge, result);
+    return false;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::answerLocally(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType& result) {
+    if (lookupCachedVerdict(config, licenseKey, scope, metadata, result)) return true;
+    if (!config.verdictStore || config.verdictStore->getOptions().freshFor.count() <= 0) return false;
+    if (!lookupStoredVerdict(config, licenseKey, scope, metadata, config.verdictStore->getOptions().freshFor, result)) return false;
+
+    cacheVerdict(config, licenseKey, scope, metadata, result);
+    return true;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::lookupStoredVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata,
+    std::chrono::seconds maxAge, ValidationType& result) {
+    VerdictStore::Record record;
+    if (!config.verdictStore->lookup(VerdictStore::keyOf(userId, licenseKey, scope, metadata), record)) return false;
+
+    ValidationType verdict = static_cast<ValidationType>(record.verdict);
+    if (verdict != ValidationType::VALID && verdict != ValidationType::NOT_FOUND
+        && verdict != ValidationType::NOT_ACTIVE && verdict != ValidationType::EXPIRED) return false;
+
+    int64_t verifiedAt = record.timestamp;
+    if (verdict == ValidationType::VALID && challengesOn(config)) {
+        // The signed challenge is the verification time; the record timestamp is not signed.
+        std::string challenge(record.challenge, record.challengeLength);
+        std::string signedChallenge(record.signedChallenge, record.signatureLength);
+        if (challenge.empty() || signedChallenge.empty() || !verifyChallenge(config, challenge, signedChallenge)) return false;
+        try {
+            verifiedAt = std::stoll(challenge);
+        }
+        catch (...) {
+            return false;
+        }
+    }
+
+    int64_t age = static_cast<int64_t>(std::time(nullptr)) - verifiedAt;
+    if (age < 0 || age > maxAge.count()) return false;
+
+    result = verdict;
+    return true;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::storeVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType result,
+    const std::string& challenge, const std::string& signedChallenge) {
+    if (!config.verdictStore) return;
+
+    switch (result) {
+    case ValidationType::VALID:
+    case ValidationType::NOT_FOUND:
+    case ValidationType::NOT_ACTIVE:
+    case ValidationType::EXPIRED:
+        config.verdictStore->append(VerdictStore::keyOf(userId, licenseKey, scope, metadata), static_cast<int>(result), challenge, signedChallenge);
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::cacheVerdict(const Config& config, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType result) {
+    VerdictCache* cache = cacheOf(config);
+    if (!cache) return;
+
+    switch (result) {
+    case ValidationType::VALID:
+        cache->store(userId, licenseKey, scope, metadata, static_cast<int>(result), cache->getOptions().validTtl);
+        break;
+    case ValidationType::NOT_FOUND:
+    case ValidationType::NOT_ACTIVE:
+    case ValidationType::EXPIRED:
+        cache->store(userId, licenseKey, scope, metadata, static_cast<int>(result), cache->getOptions().negativeTtl);
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::recordResult(ValidationType result, std::chrono::steady_clock::time_point start) {
+    metrics.record(Metrics::Phase::Verify, std::chrono::steady_clock::now() - start);
+    metrics.countResult(static_cast<size_t>(result));
+    return result;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+AsyncEngine& BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::getAsyncEngine() {
+    std::lock_guard<std::mutex> lock(asyncEngineMutex);
+    if (!asyncEngine) asyncEngine.reset(new AsyncEngine());
+    return *asyncEngine;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+void BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::prepareRequest(const Config& config, CURL* curl, const std::string& urlStr, Response* response) {
+    response->parser.reset();
+    response->body.clear();
+    Logger* logger = loggerOf(config);
+    response->keepBody = logger && logger->sampleResponse();
+    response->parseTime = std::chrono::nanoseconds::zero();
+
+    curl_easy_setopt(curl, CURLOPT_URL, urlStr.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+CURLcode BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::requestServer(const Config& config, const std::string& urlStr, Response& response, const Limits& limits) {
+    ConnectionPool::Lease curl(connectionPool);
+    if (!curl) throw std::runtime_error(xorstr_("Failed to initialize CURL"));
+
+    prepareRequest(config, curl.get(), urlStr, &response);
+    CURLcode res = limits.bounded() ? performWithin(curl.get(), limits) : curl_easy_perform(curl.get());
+    if (res == CURLE_OK) metrics.recordTransfer(curl.get());
+    return res;
+}
+
+// Runs the transfer on this thread's multi handle rather than with curl_easy_perform, so that
+// cancelling the token can wake it. Running out of time is reported as CURLE_OPERATION_TIMEDOUT,
+// cancellation as CURLE_ABORTED_BY_CALLBACK; either way the connection is closed, and the handle
+// goes back to the pool as soon as the caller returns.
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+CURLcode BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::performWithin(CURL* curl, const Limits& limits) {
+    CURLM* multi = LicenseGateDetail::threadMulti();
+    if (!multi) return CURLE_FAILED_INIT;
+    std::optional<CancellationToken::Listener> listener;
+    if (limits.cancellation) listener.emplace(*limits.cancellation, [multi]() { curl_multi_wakeup(multi); });
+
+    LicenseGateDetail::limitTransfer(curl, limits.deadline);
+    if (curl_multi_add_handle(multi, curl) != CURLM_OK) return CURLE_FAILED_INIT;
+
+    CURLcode res = CURLE_OK;
+    for (bool done = false; !done;) {
+        ValidationType expired;
+        if (limits.exceeded(std::chrono::steady_clock::now(), expired)) {
+            res = expired == ValidationType::TIMEOUT ? CURLE_OPERATION_TIMEDOUT : CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE || message->easy_handle != curl) continue;
+            res = message->data.result;
+            done = true;
+        }
+        if (!done) curl_multi_poll(multi, NULL, 0, LicenseGateDetail::pollTimeout(limits.deadline, 1000), NULL);
+    }
+    curl_multi_remove_handle(multi, curl);
+    return res;
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::parseResponse(const Config& config, Response& response) {
+    Logger* logger = loggerOf(config);
+    if (response.keepBody && logger)
+        logger->log(Logger::Level::Debug, xorstr_("Response: %.*s"), static_cast<int>(response.body.size()), response.body.data());
+
+    return response.parser.finish();
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+bool BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::verifyChallenge(const Config& config, const std::string& challenge, std::string_view signedChallengeBase64) {
+    auto start = std::chrono::steady_clock::now();
+    thread_local std::vector<unsigned char> signedChallenge;
+    size_t signedChallengeLength = 0;
+    signedChallenge.resize(Base64::maxDecodedSize(signedChallengeBase64.size()));
+    if (!Base64::decode(signedChallengeBase64, signedChallenge.data(), signedChallengeLength)) {
+        if (Logger* log = logAt(config, Logger::Level::Warning))
+            log->log(Logger::Level::Warning, xorstr_("Signature verification failed: signedChallenge is not valid base64"));
+        return false;
+    }
+
+    if (keyRing.empty()) {
+        if (Logger* log = logAt(config, Logger::Level::Error)) log->log(Logger::Level::Error, xorstr_("Error reading public key: no public key loaded"));
+        return false;
+    }
+
+    bool verified = keyRing.verify(config.activeKeyId, signedChallenge.data(), signedChallengeLength,
+        (const unsigned char*)challenge.c_str(), challenge.size());
+    metrics.record(Metrics::Phase::Challenge, std::chrono::steady_clock::now() - start);
+
+    if (verified) {
+        if (Logger* log = logAt(config, Logger::Level::Debug)) log->log(Logger::Level::Debug, xorstr_("Signature verification succeeded!"));
+        return true;
+    }
+    else {
+        if (Logger* log = logAt(config, Logger::Level::Warning))
+            log->log(Logger::Level::Warning, xorstr_("Signature verification failed: %s"), ERR_error_string(ERR_get_error(), NULL));
+        return false;
+    }
+}
+
+template <typename ChallengePolicy, typename DebugPolicy, typename CachePolicy>
+LicenseGateBase::ValidationType BasicLicenseGate<ChallengePolicy, DebugPolicy, CachePolicy>::getValidationType(std::string_view result) {
+    using namespace LicenseGateDetail;
+    if (result.empty()) return ValidationType::SERVER_ERROR;
+
+    int code = resultSlots.codes[resultSlot(result.size(), result[0])];
+    if (code < 0) return ValidationType::SERVER_ERROR;
+    if (result != literal(resultLiteral(code))) return ValidationType::SERVER_ERROR;
+    return static_cast<ValidationType>(code);
+}
+
+#endif // LICENSE_GATE_IMPL_H
@@ -0,0 +1,29 @@
+#ifndef LICENSE_GATE_POLICY_H
+#define LICENSE_GATE_POLICY_H
+
+#include <type_traits>
+
+// Compile-time switches for the optional features of BasicLicenseGate: challenges, debug
+// logging and the verdict cache. Runtime leaves the feature to its setter, as LicenseGate
+// does. Enabled turns it on from construction, Disabled leaves it out of the binary; with
+// either of them the checks on the request path are constants.
+namespace LicenseGatePolicy {
+    struct Runtime {};
+    struct Enabled {};
+    struct Disabled {};
+
+    template <typename Policy>
+    constexpr bool compiled() {
+        static_assert(std::is_same<Policy, Runtime>::value || std::is_same<Policy, Enabled>::value || std::is_same<Policy, Disabled>::value,
+            "LicenseGate policies are Runtime, Enabled or Disabled");
+        return !std::is_same<Policy, Disabled>::value;
+    }
+
+    // Whether the feature is on, given what its setter asked for.
+    template <typename Policy>
+    constexpr bool active(bool requested) {
+        return compiled<Policy>() && (std::is_same<Policy, Enabled>::value || requested);
+    }
+}
+
+#endif // LICENSE_GATE_POLICY_H
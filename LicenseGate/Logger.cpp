@@ -0,0 +1,207 @@
+#include "Logger.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+namespace {
+    std::atomic<uint64_t> nextLoggerId{ 1 };
+
+    size_t roundUpToPowerOfTwo(size_t value) {
+        size_t capacity = 2;
+        while (capacity < value) capacity <<= 1;
+        return capacity;
+    }
+
+    void appendTimestamp(std::string& out, Logger::Clock::time_point time) {
+        auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        std::time_t seconds = static_cast<std::time_t>(milliseconds / 1000);
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        char buffer[32];
+        size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+        std::snprintf(buffer + length, sizeof(buffer) - length, ".%03dZ", static_cast<int>(milliseconds % 1000));
+        out.append(buffer);
+    }
+}
+
+// Every ring the thread has written to, one per logger. When the thread exits its rings are
+// left for the loggers to drain and release.
+struct Logger::ThreadRings {
+    std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+
+    ~ThreadRings() {
+        for (auto& entry : rings) entry.second->abandoned.store(true, std::memory_order_release);
+    }
+};
+
+Logger::Ring::Ring(size_t capacity, uint32_t thread) : slots(new Slot[capacity]), mask(capacity - 1), thread(thread) {
+}
+
+Logger::Logger(const Options& options)
+    : options(options), id(nextLoggerId.fetch_add(1, std::memory_order_relaxed)), ringCapacity(roundUpToPowerOfTwo(options.ringSize)) {
+    drainer = std::thread([this]() { drainLoop(); });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopped = true;
+    }
+    wake.notify_all();
+    drainer.join();
+    drain();
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (auto& ring : rings) ring->closed.store(true, std::memory_order_release);
+}
+
+Logger::Ring* Logger::ringForThisThread() {
+    thread_local ThreadRings local;
+    for (auto& entry : local.rings) {
+        if (entry.first == id) return entry.second.get();
+    }
+
+    // First record from this thread. Rings of loggers that are gone are dropped here.
+    local.rings.erase(std::remove_if(local.rings.begin(), local.rings.end(), [](const std::pair<uint64_t, std::shared_ptr<Ring>>& entry) {
+        return entry.second->closed.load(std::memory_order_acquire);
+    }), local.rings.end());
+    std::shared_ptr<Ring> ring;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        ring = std::make_shared<Ring>(ringCapacity, nextThread++);
+        rings.push_back(ring);
+    }
+    local.rings.emplace_back(id, ring);
+    return ring.get();
+}
+
+void Logger::log(Level level, const char* format, ...) {
+    if (!enabled(level)) return;
+
+    Ring& ring = *ringForThisThread();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t used = head - ring.tail.load(std::memory_order_acquire);
+    if (used > ring.mask) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Slot& slot = ring.slots[head & ring.mask];
+    slot.time = Clock::now();
+    slot.level = level;
+    va_list arguments;
+    va_start(arguments, format);
+    int length = std::vsnprintf(slot.message, sizeof(slot.message), format, arguments);
+    va_end(arguments);
+    if (length < 0) length = 0;
+    if (static_cast<size_t>(length) > maxMessageLength) {
+        ring.truncated.fetch_add(1, std::memory_order_relaxed);
+        length = static_cast<int>(maxMessageLength);
+    }
+    slot.length = static_cast<uint16_t>(length);
+    ring.head.store(head + 1, std::memory_order_release);
+    if (used == ring.mask / 2) wake.notify_one();
+}
+
+bool Logger::sampleResponse() {
+    if (options.responseSampleEvery == 0 || !enabled(Level::Debug)) return false;
+    Ring& ring = *ringForThisThread();
+    return ring.responses++ % options.responseSampleEvery == 0;
+}
+
+void Logger::flush() {
+    drain();
+}
+
+void Logger::drainLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopped) {
+        wake.wait_for(lock, options.drainInterval);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+// Slots stay in their rings until the sink has seen them; only then do the tails move and the
+// producers get the space back.
+void Logger::drain() {
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (const auto& ring : rings) pending.push_back({ ring, 0, false });
+    }
+
+    for (Pending& entry : pending) {
+        Ring& ring = *entry.ring;
+        // Read before head: once the thread has exited, this head is its last.
+        entry.abandoned = ring.abandoned.load(std::memory_order_acquire);
+        entry.head = ring.head.load(std::memory_order_acquire);
+        for (uint64_t i = ring.tail.load(std::memory_order_relaxed); i != entry.head; ++i) batch.push_back({ &ring.slots[i & ring.mask], ring.thread, i });
+    }
+    // std::sort rather than stable_sort, which allocates; thread and index keep each ring in order.
+    std::sort(batch.begin(), batch.end(), [](const Entry& a, const Entry& b) {
+        if (a.slot->time != b.slot->time) return a.slot->time < b.slot->time;
+        if (a.thread != b.thread) return a.thread < b.thread;
+        return a.index < b.index;
+    });
+
+    output.clear();
+    for (const Entry& entry : batch) {
+        std::string_view message(entry.slot->message, entry.slot->length);
+        if (options.sink) {
+            try {
+                options.sink({ entry.slot->time, entry.slot->level, entry.thread, message });
+            }
+            catch (...) {}
+            continue;
+        }
+        appendTimestamp(output, entry.slot->time);
+        output.append(" ").append(levelName(entry.slot->level)).append(" [").append(std::to_string(entry.thread)).append("] ");
+        output.append(message.data(), message.size()).append("\n");
+    }
+    if (!output.empty()) {
+        std::cerr.write(output.data(), static_cast<std::streamsize>(output.size()));
+        std::cerr.flush();
+    }
+
+    for (Pending& entry : pending) entry.ring->tail.store(entry.head, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (Pending& entry : pending) {
+        if (!entry.abandoned) continue;
+        released.logged += entry.head;
+        released.dropped += entry.ring->dropped.load(std::memory_order_relaxed);
+        released.truncated += entry.ring->truncated.load(std::memory_order_relaxed);
+        rings.erase(std::remove(rings.begin(), rings.end(), entry.ring), rings.end());
+    }
+    pending.clear();
+    batch.clear();
+}
+
+Logger::Stats Logger::stats() const {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    Stats stats = released;
+    for (const auto& ring : rings) {
+        stats.logged += ring->head.load(std::memory_order_relaxed);
+        stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+        stats.truncated += ring->truncated.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+const char* Logger::levelName(Level level) {
+    switch (level) {
+    case Level::Debug: return "DEBUG";
+    case Level::Info: return "INFO";
+    case Level::Warning: return "WARNING";
+    case Level::Error: return "ERROR";
+    }
+    return "UNKNOWN";
+}
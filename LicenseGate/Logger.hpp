@@ -0,0 +1,151 @@
+#ifndef LICENSE_GATE_LOGGER_H
+#define LICENSE_GATE_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LICENSE_GATE_PRINTF_FORMAT(formatIndex, firstArgument) __attribute__((format(printf, formatIndex, firstArgument)))
+#else
+#define LICENSE_GATE_PRINTF_FORMAT(formatIndex, firstArgument)
+#endif
+
+// Debug output that never makes the logging thread wait. Each thread formats its records into
+// its own fixed-size ring, without locking or allocating; a background thread moves them to
+// the sink in time order, every drainInterval or as soon as a ring is half full. When a ring
+// is full the record is dropped and counted. Response bodies can be sampled so that debug
+// mode stays usable under load.
+class Logger {
+public:
+    using Clock = std::chrono::system_clock;
+
+    enum class Level : uint8_t {
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+
+    // Longer messages are cut off and counted as truncated.
+    static constexpr size_t maxMessageLength = 1000;
+
+    struct Record {
+        Clock::time_point time;
+        Level level;
+        uint32_t thread; // numbered in the order threads first logged
+        std::string_view message;
+    };
+
+    // Runs on the logger's thread, one call per record.
+    using Sink = std::function<void(const Record& record)>;
+
+    struct Options {
+        Level level = Level::Debug;
+        // Records buffered per thread before new ones are dropped.
+        size_t ringSize = 128;
+        std::chrono::milliseconds drainInterval = std::chrono::milliseconds(50);
+        // Logs the body of one in every responseSampleEvery responses on each thread; 0 logs none.
+        uint32_t responseSampleEvery = 1;
+        // Empty to write one line per record to stderr.
+        Sink sink;
+    };
+
+    struct Stats {
+        uint64_t logged = 0;
+        uint64_t dropped = 0;
+        uint64_t truncated = 0;
+    };
+
+    explicit Logger(const Options& options);
+    // Delivers whatever is still buffered before returning.
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    bool enabled(Level level) const { return level >= options.level; }
+    void log(Level level, const char* format, ...) LICENSE_GATE_PRINTF_FORMAT(3, 4);
+    // Whether the calling thread should log the response it is about to receive.
+    bool sampleResponse();
+
+    // Hands every buffered record to the sink now.
+    void flush();
+
+    const Options& getOptions() const { return options; }
+    Stats stats() const;
+    static const char* levelName(Level level);
+
+private:
+    struct Slot {
+        Clock::time_point time;
+        Level level;
+        uint16_t length;
+        char message[maxMessageLength + 1];
+    };
+
+    // Single producer, the thread that owns it, and single consumer, whoever holds drainMutex.
+    struct Ring {
+        Ring(size_t capacity, uint32_t thread);
+
+        std::unique_ptr<Slot[]> slots;
+        const uint64_t mask;
+        const uint32_t thread;
+        alignas(64) std::atomic<uint64_t> head{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> truncated{ 0 };
+        uint64_t responses = 0;
+        alignas(64) std::atomic<uint64_t> tail{ 0 };
+        // Set when the owning thread exits; the ring is released once drained.
+        std::atomic<bool> abandoned{ false };
+        std::atomic<bool> closed{ false };
+    };
+
+    struct ThreadRings;
+
+    struct Pending {
+        std::shared_ptr<Ring> ring;
+        uint64_t head;
+        bool abandoned;
+    };
+    struct Entry {
+        const Slot* slot;
+        uint32_t thread;
+        uint64_t index;
+    };
+
+    Ring* ringForThisThread();
+    void drainLoop();
+    void drain();
+
+    const Options options;
+    const uint64_t id;
+    const size_t ringCapacity;
+
+    mutable std::mutex ringsMutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    uint32_t nextThread = 0;
+    Stats released;
+
+    // Guards the drain buffers, which are kept between drains so that draining does not allocate.
+    std::mutex drainMutex;
+    std::vector<Pending> pending;
+    std::vector<Entry> batch;
+    std::string output;
+
+    std::mutex wakeMutex;
+    // Notified without the mutex when a ring fills up halfway; a missed wakeup only means
+    // waiting out drainInterval.
+    std::condition_variable wake;
+    bool stopped = false;
+    std::thread drainer;
+};
+
+#endif // LICENSE_GATE_LOGGER_H
@@ -0,0 +1,129 @@
+#include "Metrics.hpp"
+#include <locale>
+#include <sstream>
+
+namespace {
+    size_t bucketFor(uint64_t nanoseconds) {
+        uint64_t micros = (nanoseconds + 999) / 1000;
+        size_t bucket = 0;
+        for (uint64_t rest = micros > 8 ? (micros - 1) >> 3 : 0; rest != 0; rest >>= 1) ++bucket;
+        return bucket < Metrics::bucketCount ? bucket : Metrics::bucketCount - 1;
+    }
+
+    std::chrono::nanoseconds between(curl_off_t from, curl_off_t to) {
+        return std::chrono::microseconds(to > from ? to - from : 0);
+    }
+}
+
+double Metrics::bucketBoundSeconds(size_t bucket) {
+    return 8e-6 * static_cast<double>(uint64_t(1) << bucket);
+}
+
+double Metrics::Histogram::quantile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) return bucketBoundSeconds(i);
+    }
+    return bucketBoundSeconds(bucketCount - 1);
+}
+
+Metrics::Metrics(std::vector<std::string> resultNames)
+    : resultNames(std::move(resultNames)), results(new std::atomic<uint64_t>[this->resultNames.size()]) {
+    for (size_t i = 0; i < this->resultNames.size(); ++i) results[i].store(0, std::memory_order_relaxed);
+}
+
+void Metrics::record(Phase phase, std::chrono::nanoseconds duration) {
+    uint64_t nanoseconds = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    Counters& counters = phases[static_cast<size_t>(phase)];
+    counters.buckets[bucketFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    counters.sumNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void Metrics::recordTransfer(CURL* curl) {
+    // All *_TIME_T values are microseconds from the start of the transfer.
+    curl_off_t nameLookup = 0, connect = 0, appConnect = 0, preTransfer = 0, startTransfer = 0, total = 0;
+    long newConnections = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+    curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &preTransfer);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &newConnections);
+
+    // A reused connection reports zero for these, which would only drown out real handshakes.
+    if (newConnections > 0) {
+        record(Phase::DnsLookup, between(0, nameLookup));
+        record(Phase::Connect, between(nameLookup, connect));
+        if (appConnect > 0) record(Phase::TlsHandshake, between(connect, appConnect));
+    }
+    if (startTransfer > 0) {
+        record(Phase::Server, between(preTransfer, startTransfer));
+        record(Phase::Transfer, between(startTransfer, total));
+    }
+}
+
+void Metrics::countResult(size_t result) {
+    if (result < resultNames.size()) results[result].fetch_add(1, std::memory_order_relaxed);
+}
+
+Metrics::Stats Metrics::stats() const {
+    Stats stats;
+    for (size_t phase = 0; phase < phaseCount; ++phase) {
+        Histogram& histogram = stats.phases[phase];
+        for (size_t i = 0; i < bucketCount; ++i) {
+            histogram.buckets[i] = phases[phase].buckets[i].load(std::memory_order_relaxed);
+            histogram.count += histogram.buckets[i];
+        }
+        histogram.sumSeconds = phases[phase].sumNanoseconds.load(std::memory_order_relaxed) / 1e9;
+    }
+    for (size_t i = 0; i < resultNames.size(); ++i)
+        stats.results.emplace_back(resultNames[i], results[i].load(std::memory_order_relaxed));
+    return stats;
+}
+
+std::string Metrics::prometheus() const {
+    Stats current = stats();
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+
+    out << "# HELP licensegate_phase_duration_seconds Time spent in each phase of a license verification.\n";
+    out << "# TYPE licensegate_phase_duration_seconds histogram\n";
+    for (size_t phase = 0; phase < phaseCount; ++phase) {
+        const Histogram& histogram = current.phases[phase];
+        const char* name = phaseName(static_cast<Phase>(phase));
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i + 1 < bucketCount; ++i) {
+            cumulative += histogram.buckets[i];
+            out << "licensegate_phase_duration_seconds_bucket{phase=\"" << name << "\",le=\"" << bucketBoundSeconds(i) << "\"} " << cumulative << "\n";
+        }
+        out << "licensegate_phase_duration_seconds_bucket{phase=\"" << name << "\",le=\"+Inf\"} " << histogram.count << "\n";
+        out << "licensegate_phase_duration_seconds_sum{phase=\"" << name << "\"} " << histogram.sumSeconds << "\n";
+        out << "licensegate_phase_duration_seconds_count{phase=\"" << name << "\"} " << histogram.count << "\n";
+    }
+
+    out << "# HELP licensegate_verifications_total License verifications by result.\n";
+    out << "# TYPE licensegate_verifications_total counter\n";
+    for (const auto& result : current.results)
+        out << "licensegate_verifications_total{result=\"" << result.first << "\"} " << result.second << "\n";
+
+    return out.str();
+}
+
+const char* Metrics::phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::DnsLookup: return "dns";
+    case Phase::Connect: return "connect";
+    case Phase::TlsHandshake: return "tls";
+    case Phase::Server: return "server";
+    case Phase::Transfer: return "transfer";
+    case Phase::Parse: return "parse";
+    case Phase::Challenge: return "challenge";
+    case Phase::Verify: return "verify";
+    case Phase::Count: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,72 @@
+#ifndef LICENSE_GATE_METRICS_H
+#define LICENSE_GATE_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+
+// Latency histograms for each phase of a verification and a counter per result. Recording is
+// a few relaxed atomic increments, so it stays on for every call; readers take a snapshot.
+class Metrics {
+public:
+    enum class Phase : uint8_t {
+        DnsLookup,   // name resolution, only for calls that opened a connection
+        Connect,     // TCP connect, only for calls that opened a connection
+        TlsHandshake,
+        Server,      // request sent until the first response byte
+        Transfer,    // first response byte until the body is complete
+        Parse,       // response parsing, including the bytes parsed as they arrived
+        Challenge,   // signature verification
+        Verify,      // the whole call, as seen by the caller
+        Count
+    };
+    static constexpr size_t phaseCount = static_cast<size_t>(Phase::Count);
+
+    // Bucket i counts durations up to 8us * 2^i; the last bucket counts everything longer.
+    static constexpr size_t bucketCount = 22;
+    static double bucketBoundSeconds(size_t bucket);
+
+    struct Histogram {
+        std::array<uint64_t, bucketCount> buckets{};
+        uint64_t count = 0;
+        double sumSeconds = 0;
+
+        // Upper bound of the bucket holding the given quantile, in seconds; 0 when empty.
+        double quantile(double q) const;
+    };
+
+    struct Stats {
+        std::array<Histogram, phaseCount> phases;
+        std::vector<std::pair<std::string, uint64_t>> results;
+
+        const Histogram& phase(Phase phase) const { return phases[static_cast<size_t>(phase)]; }
+    };
+
+    explicit Metrics(std::vector<std::string> resultNames);
+
+    void record(Phase phase, std::chrono::nanoseconds duration);
+    void recordTransfer(CURL* curl);
+    void countResult(size_t result);
+
+    Stats stats() const;
+    std::string prometheus() const;
+
+    static const char* phaseName(Phase phase);
+
+private:
+    struct Counters {
+        std::array<std::atomic<uint64_t>, bucketCount> buckets{};
+        std::atomic<uint64_t> sumNanoseconds{ 0 };
+    };
+
+    std::array<Counters, phaseCount> phases;
+    std::vector<std::string> resultNames;
+    std::unique_ptr<std::atomic<uint64_t>[]> results;
+};
+
+#endif // LICENSE_GATE_METRICS_H
@@ -0,0 +1,115 @@
+#include "RateLimiter.hpp"
+#include "XorStr.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    constexpr int64_t nanosecondsPerSecond = 1000000000;
+    // Answers to requests already in flight when the rate changed say nothing about the new rate.
+    constexpr int64_t adjustEvery = nanosecondsPerSecond;
+
+    bool sameOptions(const RateLimiter::Options& a, const RateLimiter::Options& b) {
+        return a.requestsPerSecond == b.requestsPerSecond && a.burst == b.burst && a.overLimit == b.overLimit
+            && a.maxQueueDelay == b.maxQueueDelay && a.adaptive == b.adaptive && a.minRequestsPerSecond == b.minRequestsPerSecond;
+    }
+}
+
+std::shared_ptr<RateLimiter> RateLimiter::forUser(const std::string& userId, const Options& options) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<RateLimiter>> limiters;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = limiters.begin(); it != limiters.end();) {
+        if (it->second.expired()) it = limiters.erase(it);
+        else ++it;
+    }
+
+    std::weak_ptr<RateLimiter>& slot = limiters[userId];
+    std::shared_ptr<RateLimiter> limiter = slot.lock();
+    if (limiter) {
+        // Two buckets for one account would let the process send twice the rate it asked for.
+        if (!sameOptions(limiter->getOptions(), options))
+            throw std::runtime_error(xorstr_("A rate limit with different options is already in use for this userId"));
+        return limiter;
+    }
+    limiter = std::make_shared<RateLimiter>(options);
+    slot = limiter;
+    return limiter;
+}
+
+RateLimiter::RateLimiter(const Options& options) : options(options), minInterval(intervalFor(options.requestsPerSecond)),
+    maxInterval(intervalFor(std::min(options.minRequestsPerSecond, options.requestsPerSecond))), interval(minInterval) {
+}
+
+int64_t RateLimiter::intervalFor(double requestsPerSecond) const {
+    return static_cast<int64_t>(nanosecondsPerSecond / std::max(requestsPerSecond, 0.001));
+}
+
+bool RateLimiter::acquire(Clock::time_point now, Clock::duration& wait) {
+    int64_t maxWait = options.overLimit == OverLimit::Queue ? std::chrono::duration_cast<std::chrono::nanoseconds>(options.maxQueueDelay).count() : 0;
+    if (take(now, maxWait, wait)) return true;
+    rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool RateLimiter::tryAcquire(Clock::time_point now) {
+    Clock::duration wait;
+    return take(now, 0, wait);
+}
+
+bool RateLimiter::take(Clock::time_point now, int64_t maxWait, Clock::duration& wait) {
+    int64_t current = ticks(now);
+    int64_t step = interval.load(std::memory_order_relaxed);
+    int64_t tolerance = static_cast<int64_t>((std::max(options.burst, 1.0) - 1) * step);
+
+    int64_t expected = arrival.load(std::memory_order_relaxed);
+    for (;;) {
+        int64_t base = std::max(expected, current);
+        int64_t waitTicks = base - tolerance - current;
+        if (waitTicks > maxWait) return false;
+        if (arrival.compare_exchange_weak(expected, base + step, std::memory_order_relaxed)) {
+            admitted.fetch_add(1, std::memory_order_relaxed);
+            if (waitTicks > 0) delayed.fetch_add(1, std::memory_order_relaxed);
+            wait = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(std::max<int64_t>(waitTicks, 0)));
+            return true;
+        }
+    }
+}
+
+void RateLimiter::record(bool rateLimited, Clock::time_point now) {
+    if (rateLimited) serverLimited.fetch_add(1, std::memory_order_relaxed);
+    if (!options.adaptive) return;
+
+    int64_t current = ticks(now);
+    int64_t step = interval.load(std::memory_order_relaxed);
+    if (!rateLimited && step <= minInterval) return;
+
+    int64_t last = lastChange.load(std::memory_order_relaxed);
+    if (current - last < adjustEvery || !lastChange.compare_exchange_strong(last, current, std::memory_order_relaxed)) return;
+
+    if (!rateLimited) {
+        double rate = static_cast<double>(nanosecondsPerSecond) / step + options.requestsPerSecond * increaseFraction;
+        interval.store(std::max(minInterval, intervalFor(rate)), std::memory_order_relaxed);
+        return;
+    }
+
+    int64_t slower = std::min(maxInterval, static_cast<int64_t>(step / decreaseFactor));
+    interval.store(slower, std::memory_order_relaxed);
+
+    // Drop the banked burst as well, so that the requests right after are paced at the new rate.
+    int64_t drained = current + static_cast<int64_t>((std::max(options.burst, 1.0) - 1) * slower);
+    int64_t expected = arrival.load(std::memory_order_relaxed);
+    while (expected < drained && !arrival.compare_exchange_weak(expected, drained, std::memory_order_relaxed)) {}
+}
+
+RateLimiter::Stats RateLimiter::stats() const {
+    Stats stats;
+    stats.requestsPerSecond = static_cast<double>(nanosecondsPerSecond) / interval.load(std::memory_order_relaxed);
+    stats.admitted = admitted.load(std::memory_order_relaxed);
+    stats.delayed = delayed.load(std::memory_order_relaxed);
+    stats.rejected = rejected.load(std::memory_order_relaxed);
+    stats.serverLimited = serverLimited.load(std::memory_order_relaxed);
+    return stats;
+}
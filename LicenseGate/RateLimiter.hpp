@@ -0,0 +1,84 @@
+#ifndef LICENSE_GATE_RATE_LIMITER_H
+#define LICENSE_GATE_RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Paces requests to the validation server so that bursts are smoothed on the client instead of
+// being answered with RATE_LIMIT_EXCEEDED. The bucket is kept as the generic cell rate
+// algorithm: a single theoretical arrival time advanced by one emission interval per request,
+// so taking a token is one compare-and-swap. With adaptive set, the rate drops to 70% when the
+// server reports rate limiting, at most once a second, and grows back by a tenth of the
+// configured rate per second.
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class OverLimit {
+        Queue,      // wait up to maxQueueDelay for a token, then fail fast
+        FailFast,   // answer RATE_LIMIT_EXCEEDED without asking the server
+        ServeStale  // answer from the verdict store, as when offline; otherwise fail fast
+    };
+
+    struct Options {
+        double requestsPerSecond = 10;
+        double burst = 10;
+        OverLimit overLimit = OverLimit::Queue;
+        std::chrono::milliseconds maxQueueDelay = std::chrono::seconds(1);
+        bool adaptive = true;
+        double minRequestsPerSecond = 1;
+    };
+
+    struct Stats {
+        double requestsPerSecond = 0;
+        uint64_t admitted = 0;
+        uint64_t delayed = 0;
+        uint64_t rejected = 0;
+        uint64_t serverLimited = 0;
+    };
+
+    // Instances for the same userId share one limiter, since the server counts requests per
+    // account. Throws if that limiter is still in use with different options.
+    static std::shared_ptr<RateLimiter> forUser(const std::string& userId, const Options& options);
+
+    explicit RateLimiter(const Options& options);
+
+    const Options& getOptions() const { return options; }
+
+    // Takes a token and sets wait to how long the caller must hold the request. False, with
+    // nothing taken, if the request is over the limit.
+    bool acquire(Clock::time_point now, Clock::duration& wait);
+    // Takes a token only if one is available right away, whatever overLimit says.
+    bool tryAcquire(Clock::time_point now);
+
+    // Feeds an answer from the server back into the adaptive rate.
+    void record(bool rateLimited, Clock::time_point now);
+
+    Stats stats() const;
+
+private:
+    static constexpr double decreaseFactor = 0.7;
+    static constexpr double increaseFraction = 0.1;
+
+    static int64_t ticks(Clock::time_point time) { return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(); }
+    int64_t intervalFor(double requestsPerSecond) const;
+    bool take(Clock::time_point now, int64_t maxWait, Clock::duration& wait);
+
+    const Options options;
+    const int64_t minInterval;
+    const int64_t maxInterval;
+
+    std::atomic<int64_t> interval;         // nanoseconds per token at the current rate
+    std::atomic<int64_t> arrival{ 0 };     // theoretical arrival time of the next request
+    std::atomic<int64_t> lastChange{ 0 };  // last adaptive rate change
+
+    std::atomic<uint64_t> admitted{ 0 };
+    std::atomic<uint64_t> delayed{ 0 };
+    std::atomic<uint64_t> rejected{ 0 };
+    std::atomic<uint64_t> serverLimited{ 0 };
+};
+
+#endif // LICENSE_GATE_RATE_LIMITER_H
@@ -0,0 +1,172 @@
+#include "RefreshScheduler.hpp"
+#include <algorithm>
+
+RefreshScheduler::Watch::Watch(std::string licenseKey, std::string scope, std::chrono::milliseconds interval, OnChange onChange)
+    : licenseKey(std::move(licenseKey)), scope(std::move(scope)), interval(interval), onChange(std::move(onChange)) {
+}
+
+int RefreshScheduler::Watch::wait() const {
+    int current = verdict.load(std::memory_order_acquire);
+    if (current != noVerdict) return current;
+
+    std::unique_lock<std::mutex> lock(readyMutex);
+    ready.wait(lock, [this]() { return verdict.load(std::memory_order_acquire) != noVerdict; });
+    return verdict.load(std::memory_order_acquire);
+}
+
+void RefreshScheduler::Watch::publish(int next) {
+    if (verdict.load(std::memory_order_acquire) != noVerdict) {
+        verdict.store(next, std::memory_order_release);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(readyMutex);
+        verdict.store(next, std::memory_order_release);
+    }
+    ready.notify_all();
+}
+
+RefreshScheduler::RefreshScheduler(Refresh refresh, size_t maxInFlight, int fallbackVerdict, std::chrono::milliseconds tick, size_t slotCount)
+    : refresh(std::move(refresh)), maxInFlight(std::max<size_t>(1, maxInFlight)), fallbackVerdict(fallbackVerdict),
+    tick(std::max(tick, std::chrono::milliseconds(1))), slots(std::max<size_t>(1, slotCount)), random(std::random_device()()) {
+    worker = std::thread(&RefreshScheduler::run, this);
+}
+
+RefreshScheduler::~RefreshScheduler() {
+    stop();
+}
+
+std::string RefreshScheduler::keyFor(const std::string& licenseKey, const std::string& scope) {
+    std::string key;
+    key.reserve(licenseKey.size() + scope.size() + 1);
+    key.append(licenseKey).push_back('\0');
+    key.append(scope);
+    return key;
+}
+
+std::shared_ptr<RefreshScheduler::Watch> RefreshScheduler::watch(const std::string& licenseKey, const std::string& scope,
+    std::chrono::milliseconds interval, OnChange onChange) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Watch>& watch = watches[keyFor(licenseKey, scope)];
+    if (watch) return watch;
+
+    watch = std::make_shared<Watch>(licenseKey, scope, std::max(interval, tick), std::move(onChange));
+    if (stopping) {
+        watch->publish(fallbackVerdict);
+        return watch;
+    }
+    due.push_back(watch);
+    wake.notify_one();
+    return watch;
+}
+
+bool RefreshScheduler::unwatch(const std::string& licenseKey, const std::string& scope) {
+    std::shared_ptr<Watch> watch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = watches.find(keyFor(licenseKey, scope));
+        if (it == watches.end()) return false;
+        watch = std::move(it->second);
+        watches.erase(it);
+    }
+
+    // Its timer is dropped the next time the wheel passes it.
+    watch->cancelled.store(true, std::memory_order_release);
+    if (watch->verdict.load(std::memory_order_acquire) == noVerdict) watch->publish(fallbackVerdict);
+    return true;
+}
+
+size_t RefreshScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return watches.size();
+}
+
+void RefreshScheduler::complete(const std::shared_ptr<Watch>& watch, int verdict, bool transient) {
+    Clock::time_point now = Clock::now();
+    int previous = watch->verdict.load(std::memory_order_acquire);
+
+    bool keepPrevious = transient && previous != noVerdict && now - watch->lastSuccess < watch->interval * staleFactor;
+    if (!transient) watch->lastSuccess = now;
+    if (!keepPrevious) {
+        watch->publish(verdict);
+        if (previous != noVerdict && previous != verdict && watch->onChange) watch->onChange(previous, verdict);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    --inFlight;
+    if (!stopping && !watch->cancelled.load(std::memory_order_acquire))
+        schedule(watch, jittered(transient ? watch->interval / 4 : watch->interval));
+    wake.notify_one();
+}
+
+void RefreshScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : watches) {
+        if (entry.second->verdict.load(std::memory_order_acquire) == noVerdict) entry.second->publish(fallbackVerdict);
+    }
+}
+
+std::chrono::milliseconds RefreshScheduler::jittered(std::chrono::milliseconds delay) {
+    double early = std::uniform_real_distribution<double>(0, jitter)(random);
+    return std::chrono::milliseconds(static_cast<int64_t>(delay.count() * (1 - early)));
+}
+
+// A timer set n ticks ahead lands in the slot n past the cursor. The cursor reaches that slot
+// for the first time after ((n - 1) % slots) + 1 ticks and then once per revolution, so the
+// timer is due after (n - 1) / slots full revolutions.
+void RefreshScheduler::schedule(const std::shared_ptr<Watch>& watch, std::chrono::milliseconds delay) {
+    size_t ticks = static_cast<size_t>(std::max<int64_t>(1, (delay.count() + tick.count() - 1) / tick.count()));
+    slots[(cursor + ticks) % slots.size()].push_back(Timer{ watch, (ticks - 1) / slots.size() });
+}
+
+void RefreshScheduler::advance() {
+    cursor = (cursor + 1) % slots.size();
+    std::vector<Timer>& slot = slots[cursor];
+
+    size_t kept = 0;
+    for (size_t i = 0; i < slot.size(); ++i) {
+        if (slot[i].watch->cancelled.load(std::memory_order_acquire)) continue;
+        if (slot[i].rounds == 0) {
+            due.push_back(std::move(slot[i].watch));
+            continue;
+        }
+        --slot[i].rounds;
+        if (kept != i) slot[kept] = std::move(slot[i]);
+        ++kept;
+    }
+    slot.resize(kept);
+}
+
+void RefreshScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    Clock::time_point nextTick = Clock::now() + tick;
+
+    while (!stopping) {
+        wake.wait_until(lock, nextTick, [&]() {
+            return stopping || (!due.empty() && inFlight < maxInFlight) || Clock::now() >= nextTick;
+        });
+        if (stopping) break;
+
+        // Catch up on every tick missed while suspended or busy.
+        for (Clock::time_point now = Clock::now(); nextTick <= now; nextTick += tick) advance();
+
+        while (!due.empty() && inFlight < maxInFlight && !stopping) {
+            std::shared_ptr<Watch> watch = std::move(due.front());
+            due.pop_front();
+            if (watch->cancelled.load(std::memory_order_acquire)) continue;
+
+            ++inFlight;
+            lock.unlock();
+            refresh(*this, watch);
+            lock.lock();
+        }
+    }
+}
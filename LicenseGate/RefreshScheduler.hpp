@@ -0,0 +1,114 @@
+#ifndef LICENSE_GATE_REFRESH_SCHEDULER_H
+#define LICENSE_GATE_REFRESH_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Re-verifies watched licenses on a background thread, so that readers only ever load the
+// last verdict. Due times live in a hashed timer wheel: scheduling and cancelling are O(1)
+// and a tick looks at a single slot, so tens of thousands of watches cost one thread and a
+// timer each. Refreshes are started from the scheduler thread, at most maxInFlight at a time,
+// and run asynchronously; their outcome comes back through complete().
+class RefreshScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using OnChange = std::function<void(int previous, int current)>;
+
+    static constexpr int noVerdict = -1;
+
+    struct Watch {
+        Watch(std::string licenseKey, std::string scope, std::chrono::milliseconds interval, OnChange onChange);
+
+        const std::string licenseKey;
+        const std::string scope;
+        const std::chrono::milliseconds interval;
+        const OnChange onChange;
+
+        std::atomic<int> verdict{ noVerdict };
+        std::atomic<bool> cancelled{ false };
+
+        // The last verdict, waiting for the first refresh if there has not been one yet.
+        int wait() const;
+
+    private:
+        friend class RefreshScheduler;
+
+        void publish(int next);
+
+        // Only touched by complete(); a watch has at most one refresh in flight.
+        Clock::time_point lastSuccess;
+        mutable std::mutex readyMutex;
+        mutable std::condition_variable ready;
+    };
+
+    using Refresh = std::function<void(RefreshScheduler&, const std::shared_ptr<Watch>&)>;
+
+    // Refreshes start up to jitter * interval early, so that processes that started together
+    // drift apart. After a transient failure a watch keeps its verdict for up to staleFactor
+    // intervals since the last successful refresh, retrying every quarter interval.
+    static constexpr double jitter = 0.1;
+    static constexpr int staleFactor = 3;
+
+    // fallbackVerdict is published to watches that are unwatched or stopped before their
+    // first refresh finishes, so that nobody waits on them forever.
+    RefreshScheduler(Refresh refresh, size_t maxInFlight, int fallbackVerdict,
+        std::chrono::milliseconds tick = std::chrono::milliseconds(100), size_t slotCount = 1024);
+    ~RefreshScheduler();
+    RefreshScheduler(const RefreshScheduler&) = delete;
+    RefreshScheduler& operator=(const RefreshScheduler&) = delete;
+
+    // Returns the existing watch if the license is already watched with this scope.
+    std::shared_ptr<Watch> watch(const std::string& licenseKey, const std::string& scope,
+        std::chrono::milliseconds interval, OnChange onChange);
+    bool unwatch(const std::string& licenseKey, const std::string& scope);
+    size_t size() const;
+
+    // Publishes the outcome of a refresh and schedules the next one. onChange runs on the
+    // calling thread when the published verdict differs from the previous one.
+    void complete(const std::shared_ptr<Watch>& watch, int verdict, bool transient);
+
+    // Stops refreshing; refreshes already in flight may still complete afterwards.
+    void stop();
+
+private:
+    struct Timer {
+        std::shared_ptr<Watch> watch;
+        size_t rounds;
+    };
+
+    static std::string keyFor(const std::string& licenseKey, const std::string& scope);
+
+    void schedule(const std::shared_ptr<Watch>& watch, std::chrono::milliseconds delay);
+    std::chrono::milliseconds jittered(std::chrono::milliseconds delay);
+    void advance();
+    void run();
+
+    const Refresh refresh;
+    const size_t maxInFlight;
+    const int fallbackVerdict;
+    const std::chrono::milliseconds tick;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::vector<Timer>> slots;
+    size_t cursor = 0;
+    std::deque<std::shared_ptr<Watch>> due;
+    size_t inFlight = 0;
+    std::unordered_map<std::string, std::shared_ptr<Watch>> watches;
+    std::mt19937_64 random;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif // LICENSE_GATE_REFRESH_SCHEDULER_H
@@ -0,0 +1,85 @@
+#include "RequestCoalescer.hpp"
+#include <functional>
+#include <optional>
+
+bool RequestCoalescer::begin(const std::string& licenseKey, const std::string& scope, const std::string& metadata, const Bounds& bounds,
+    Flight& flight, int& result) {
+    thread_local std::string key;
+    key.clear();
+    key.append(licenseKey).push_back('\0');
+    key.append(scope).push_back('\0');
+    key.append(metadata);
+
+    flight.key = key;
+    flight.hash = std::hash<std::string_view>()(flight.key);
+    Shard& shard = shards[flight.hash % shardCount];
+    flight.shard = &shard;
+
+    // Cancelling takes the shard lock from inside the token's, so the listener is registered
+    // before the shard lock is taken and removed after it is released.
+    std::optional<CancellationToken::Listener> listener;
+    if (bounds.cancellation) {
+        listener.emplace(*bounds.cancellation, [&shard]() {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.changed.notify_all();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    for (;;) {
+        Flight* pending = shard.inFlight;
+        while (pending && (pending->hash != flight.hash || pending->key != flight.key)) pending = pending->next;
+        if (!pending) break;
+        if (follow(shard, lock, *pending, bounds, result)) return false;
+    }
+
+    flight.next = shard.inFlight;
+    shard.inFlight = &flight;
+    return true;
+}
+
+// True once the caller has its answer: the flight's result, or the one for running out of
+// bounds. A request that threw or was abandoned has no result to share, so whoever waited on
+// it runs its own.
+bool RequestCoalescer::follow(Shard& shard, std::unique_lock<std::mutex>& lock, Flight& pending, const Bounds& bounds, int& result) {
+    ++pending.waiters;
+    bool answered = true;
+    if (!bounds.cancellation && bounds.deadline == Clock::time_point::max()) {
+        shard.changed.wait(lock, [&pending] { return pending.done; });
+    }
+    else {
+        while (!pending.done) {
+            if (bounds.cancellation && bounds.cancellation->cancelled()) {
+                result = bounds.cancelledResult;
+                break;
+            }
+            if (shard.changed.wait_until(lock, bounds.deadline) == std::cv_status::timeout && !pending.done) {
+                result = bounds.expiredResult;
+                break;
+            }
+        }
+    }
+    if (pending.done) {
+        result = pending.result;
+        answered = pending.completed;
+    }
+    if (--pending.waiters == 0) shard.changed.notify_all();
+    return answered;
+}
+
+void RequestCoalescer::finish(Flight& flight, int result, bool completed) {
+    Shard& shard = *flight.shard;
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    Flight** link = &shard.inFlight;
+    while (*link != &flight) link = &(*link)->next;
+    *link = flight.next;
+
+    flight.result = result;
+    flight.completed = completed;
+    flight.done = true;
+    if (flight.waiters == 0) return;
+
+    // Waiters read the result from this frame, so it has to outlive them.
+    shard.changed.notify_all();
+    shard.changed.wait(lock, [&flight] { return flight.waiters == 0; });
+}
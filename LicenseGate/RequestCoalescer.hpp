@@ -0,0 +1,93 @@
+#ifndef LICENSE_GATE_REQUEST_COALESCER_H
+#define LICENSE_GATE_REQUEST_COALESCER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "CancellationToken.hpp"
+
+// Single-flight execution: while a request for a key is running, callers asking for the
+// same key wait for its result instead of starting their own. Keys are spread over
+// independently locked shards, and nobody holds a shard lock while a request runs.
+// A running request is a node on its caller's stack, linked into the shard and keyed on a
+// thread-local buffer, so an uncontended run does not allocate. The request must not call
+// run again on the same thread.
+class RequestCoalescer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // How long a caller is willing to wait for someone else's request. A caller that runs out
+    // of time gets expiredResult, one whose token is cancelled gets cancelledResult.
+    struct Bounds {
+        Clock::time_point deadline = Clock::time_point::max();
+        const CancellationToken* cancellation = nullptr;
+        int expiredResult = 0;
+        int cancelledResult = 0;
+    };
+
+    // Thrown by a request that gave up for its own caller's reasons, such as a deadline. That
+    // caller gets result; callers waiting on the request run it themselves.
+    struct Abandoned {
+        int result;
+    };
+
+    template <typename Request>
+    int run(const std::string& licenseKey, const std::string& scope, const std::string& metadata, Request&& request) {
+        return run(licenseKey, scope, metadata, Bounds(), std::forward<Request>(request));
+    }
+
+    template <typename Request>
+    int run(const std::string& licenseKey, const std::string& scope, const std::string& metadata, const Bounds& bounds, Request&& request) {
+        Flight flight;
+        int result = 0;
+        if (!begin(licenseKey, scope, metadata, bounds, flight, result)) return result;
+        try {
+            result = request();
+        }
+        catch (const Abandoned& abandoned) {
+            finish(flight, 0, false);
+            return abandoned.result;
+        }
+        catch (...) {
+            finish(flight, 0, false);
+            throw;
+        }
+        finish(flight, result, true);
+        return result;
+    }
+
+private:
+    static constexpr size_t shardCount = 64;
+
+    struct Shard;
+
+    struct Flight {
+        std::string_view key;
+        size_t hash = 0;
+        Shard* shard = nullptr;
+        Flight* next = nullptr;
+        int result = 0;
+        int waiters = 0;
+        bool done = false;
+        bool completed = false;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::condition_variable changed;
+        Flight* inFlight = nullptr;
+    };
+
+    // True if the caller now leads a flight for the key; false with result set if it waited
+    // for another caller's flight instead, or ran out of bounds while waiting.
+    bool begin(const std::string& licenseKey, const std::string& scope, const std::string& metadata, const Bounds& bounds,
+        Flight& flight, int& result);
+    bool follow(Shard& shard, std::unique_lock<std::mutex>& lock, Flight& pending, const Bounds& bounds, int& result);
+    void finish(Flight& flight, int result, bool completed);
+
+    Shard shards[shardCount];
+};
+
+#endif // LICENSE_GATE_REQUEST_COALESCER_H
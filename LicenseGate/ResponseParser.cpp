@@ -0,0 +1,465 @@
+#include "ResponseParser.hpp"
+#include "StringTable.hpp"
+#include <cstring>
+
+namespace {
+    bool isWhitespace(unsigned char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // Bytes that stand for themselves inside a string and need no escape or UTF-8 handling.
+    bool isPlainStringByte(unsigned char c) {
+        return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+    }
+
+    bool isDigit(unsigned char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    int hexValue(unsigned char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    template<size_t Capacity>
+    void reset(ResponseParser::Field<Capacity>& field, ResponseParser::ValueType type) {
+        field.type = type;
+        field.overflow = false;
+        field.length = 0;
+    }
+
+    template<size_t Capacity>
+    void append(ResponseParser::Field<Capacity>& field, const char* bytes, size_t size) {
+        if (field.overflow || field.length + size > Capacity) {
+            field.overflow = true;
+            return;
+        }
+        std::memcpy(field.value + field.length, bytes, size);
+        field.length += size;
+    }
+}
+
+void ResponseParser::reset() {
+    state = State::Bom;
+    topLevel = ValueType::Missing;
+    nesting.clear();
+    ::reset(valid, ValueType::Missing);
+    ::reset(result, ValueType::Missing);
+    ::reset(error, ValueType::Missing);
+    ::reset(signedChallenge, ValueType::Missing);
+    target = Target::None;
+    valueTarget = Target::None;
+    bomIndex = 0;
+}
+
+bool ResponseParser::feed(const char* data, size_t size) {
+    if (state == State::Error) return false;
+    size_t i = 0;
+    while (i < size) {
+        // Runs of plain string bytes are copied in one go; base64 signatures are nothing else.
+        if (state == State::String && !escaped && unicodeDigits == 0 && utf8Remaining == 0 && highSurrogate == 0) {
+            size_t end = i;
+            while (end < size && isPlainStringByte(static_cast<unsigned char>(data[end]))) ++end;
+            if (end > i) {
+                appendString(data + i, end - i);
+                i = end;
+                continue;
+            }
+        }
+        if (!step(static_cast<unsigned char>(data[i++]))) return false;
+    }
+    return true;
+}
+
+bool ResponseParser::finish() {
+    if (state == State::Number) {
+        if (numberState == NumberState::Minus || numberState == NumberState::FractionStart
+            || numberState == NumberState::ExponentStart || numberState == NumberState::ExponentSign) return fail();
+        if (!endNumber() || !endValue()) return false;
+    }
+    return state == State::Done;
+}
+
+bool ResponseParser::fail() {
+    state = State::Error;
+    return false;
+}
+
+void ResponseParser::setType(ValueType type) {
+    switch (valueTarget) {
+    case Target::Valid: ::reset(valid, type); break;
+    case Target::Result: ::reset(result, type); break;
+    case Target::Error: ::reset(error, type); break;
+    case Target::SignedChallenge: ::reset(signedChallenge, type); break;
+    case Target::None: break;
+    }
+}
+
+void ResponseParser::appendString(const char* bytes, size_t size) {
+    if (stringIsKey) {
+        if (keyOverflow || keyLength + size > maxKeyLength) keyOverflow = true;
+        else {
+            std::memcpy(key + keyLength, bytes, size);
+            keyLength += size;
+        }
+        return;
+    }
+
+    switch (valueTarget) {
+    case Target::Valid: append(valid, bytes, size); break;
+    case Target::Result: append(result, bytes, size); break;
+    case Target::Error: append(error, bytes, size); break;
+    case Target::SignedChallenge: append(signedChallenge, bytes, size); break;
+    case Target::None: break;
+    }
+}
+
+bool ResponseParser::appendCodePoint(uint32_t codePoint) {
+    char bytes[4];
+    size_t size;
+    if (codePoint < 0x80) {
+        bytes[0] = static_cast<char>(codePoint);
+        size = 1;
+    }
+    else if (codePoint < 0x800) {
+        bytes[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+        bytes[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        size = 2;
+    }
+    else if (codePoint < 0x10000) {
+        bytes[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+        bytes[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        size = 3;
+    }
+    else {
+        bytes[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+        bytes[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        bytes[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        size = 4;
+    }
+    appendString(bytes, size);
+    return true;
+}
+
+bool ResponseParser::beginValue(unsigned char c) {
+    valueTarget = target;
+    target = Target::None;
+
+    ValueType type;
+    switch (c) {
+    case '{':
+        type = ValueType::Object;
+        nesting.push_back('{');
+        state = State::KeyOrObjectEnd;
+        break;
+    case '[':
+        type = ValueType::Array;
+        nesting.push_back('[');
+        state = State::ValueOrArrayEnd;
+        break;
+    case '"':
+        type = ValueType::String;
+        stringIsKey = false;
+        escaped = false;
+        unicodeDigits = 0;
+        highSurrogate = 0;
+        utf8Remaining = 0;
+        state = State::String;
+        break;
+    case 't':
+    case 'f':
+    case 'n':
+        type = c == 't' ? ValueType::True : c == 'f' ? ValueType::False : ValueType::Null;
+        literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+        literalIndex = 1;
+        state = State::Literal;
+        break;
+    default:
+        if (c != '-' && !isDigit(c)) return fail();
+        type = ValueType::Number;
+        numberState = c == '-' ? NumberState::Minus : c == '0' ? NumberState::Zero : NumberState::Integer;
+        significantLength = 0;
+        decimalExponent = 0;
+        fractionPosition = 0;
+        exponentValue = 0;
+        exponentNegative = false;
+        if (numberState == NumberState::Integer) significant[significantLength++] = static_cast<char>(c);
+        state = State::Number;
+        break;
+    }
+
+    if (nesting.size() <= (type == ValueType::Object || type == ValueType::Array ? 1u : 0u) && topLevel == ValueType::Missing)
+        topLevel = type;
+    setType(type);
+    // Members of nested containers are never captured.
+    if (type == ValueType::Object || type == ValueType::Array) valueTarget = Target::None;
+    return true;
+}
+
+bool ResponseParser::endValue() {
+    valueTarget = Target::None;
+    state = nesting.empty() ? State::Done : State::CommaOrEnd;
+    return true;
+}
+
+bool ResponseParser::step(unsigned char c) {
+    switch (state) {
+    case State::Bom:
+        if (bomIndex == 0) {
+            if (c == 0xEF) {
+                bomIndex = 1;
+                return true;
+            }
+            state = State::Value;
+            return step(c);
+        }
+        if (c != (bomIndex == 1 ? 0xBB : 0xBF)) return fail();
+        if (++bomIndex == 3) state = State::Value;
+        return true;
+
+    case State::Value:
+        if (isWhitespace(c)) return true;
+        return beginValue(c);
+
+    case State::ValueOrArrayEnd:
+        if (isWhitespace(c)) return true;
+        if (c == ']') {
+            nesting.pop_back();
+            return endValue();
+        }
+        return beginValue(c);
+
+    case State::KeyOrObjectEnd:
+        if (c == '}') {
+            nesting.pop_back();
+            return endValue();
+        }
+        // fall through
+    case State::Key:
+        if (isWhitespace(c)) return true;
+        if (c != '"') return fail();
+        stringIsKey = true;
+        escaped = false;
+        unicodeDigits = 0;
+        highSurrogate = 0;
+        utf8Remaining = 0;
+        keyLength = 0;
+        keyOverflow = false;
+        state = State::String;
+        return true;
+
+    case State::Colon:
+        if (isWhitespace(c)) return true;
+        if (c != ':') return fail();
+        state = State::Value;
+        return true;
+
+    case State::CommaOrEnd:
+        if (isWhitespace(c)) return true;
+        if (c == ',') {
+            state = nesting.back() == '{' ? State::Key : State::Value;
+            return true;
+        }
+        if ((c == '}' && nesting.back() == '{') || (c == ']' && nesting.back() == '[')) {
+            nesting.pop_back();
+            return endValue();
+        }
+        return fail();
+
+    case State::String:
+        return stringByte(c);
+
+    case State::Number:
+        return numberByte(c);
+
+    case State::Literal:
+        if (c != static_cast<unsigned char>(literal[literalIndex])) return fail();
+        if (literal[++literalIndex] == '\0') return endValue();
+        return true;
+
+    case State::Done:
+        return isWhitespace(c) || fail();
+
+    case State::Error:
+        return false;
+    }
+    return fail();
+}
+
+bool ResponseParser::stringByte(unsigned char c) {
+    if (utf8Remaining > 0) {
+        if (c < utf8Low || c > utf8High) return fail();
+        utf8Low = 0x80;
+        utf8High = 0xBF;
+        --utf8Remaining;
+        appendString(reinterpret_cast<const char*>(&c), 1);
+        return true;
+    }
+
+    if (unicodeDigits > 0) {
+        int digit = hexValue(c);
+        if (digit < 0) return fail();
+        unicodeValue = (unicodeValue << 4) | static_cast<uint32_t>(digit);
+        if (--unicodeDigits > 0) return true;
+
+        if (highSurrogate != 0) {
+            if (unicodeValue < 0xDC00 || unicodeValue > 0xDFFF) return fail();
+            uint32_t codePoint = 0x10000 + ((highSurrogate - 0xD800) << 10) + (unicodeValue - 0xDC00);
+            highSurrogate = 0;
+            return appendCodePoint(codePoint);
+        }
+        if (unicodeValue >= 0xD800 && unicodeValue <= 0xDBFF) {
+            highSurrogate = unicodeValue;
+            return true;
+        }
+        if (unicodeValue >= 0xDC00 && unicodeValue <= 0xDFFF) return fail();
+        return appendCodePoint(unicodeValue);
+    }
+
+    if (escaped) {
+        escaped = false;
+        if (highSurrogate != 0 && c != 'u') return fail();
+
+        char decoded;
+        switch (c) {
+        case '"': decoded = '"'; break;
+        case '\\': decoded = '\\'; break;
+        case '/': decoded = '/'; break;
+        case 'b': decoded = '\b'; break;
+        case 'f': decoded = '\f'; break;
+        case 'n': decoded = '\n'; break;
+        case 'r': decoded = '\r'; break;
+        case 't': decoded = '\t'; break;
+        case 'u':
+            unicodeDigits = 4;
+            unicodeValue = 0;
+            return true;
+        default:
+            return fail();
+        }
+        appendString(&decoded, 1);
+        return true;
+    }
+
+    // A high surrogate escape must be followed directly by a low surrogate escape.
+    if (highSurrogate != 0 && c != '\\') return fail();
+
+    if (c == '\\') {
+        escaped = true;
+        return true;
+    }
+
+    if (c == '"') {
+        if (!stringIsKey) return endValue();
+
+        target = Target::None;
+        if (nesting.size() == 1 && !keyOverflow) {
+            std::string_view name(key, keyLength);
+            if (name == StringTable::get(StringTable::Literal::KeyValid)) target = Target::Valid;
+            else if (name == StringTable::get(StringTable::Literal::KeyResult)) target = Target::Result;
+            else if (name == StringTable::get(StringTable::Literal::KeyError)) target = Target::Error;
+            else if (name == StringTable::get(StringTable::Literal::KeySignedChallenge)) target = Target::SignedChallenge;
+        }
+        state = State::Colon;
+        return true;
+    }
+
+    if (c < 0x20) return fail();
+
+    if (c >= 0x80) {
+        // RFC 3629 well-formed sequences, the same set nlohmann::json accepts
+        if (c >= 0xC2 && c <= 0xDF) { utf8Remaining = 1; utf8Low = 0x80; utf8High = 0xBF; }
+        else if (c == 0xE0) { utf8Remaining = 2; utf8Low = 0xA0; utf8High = 0xBF; }
+        else if ((c >= 0xE1 && c <= 0xEC) || c == 0xEE || c == 0xEF) { utf8Remaining = 2; utf8Low = 0x80; utf8High = 0xBF; }
+        else if (c == 0xED) { utf8Remaining = 2; utf8Low = 0x80; utf8High = 0x9F; }
+        else if (c == 0xF0) { utf8Remaining = 3; utf8Low = 0x90; utf8High = 0xBF; }
+        else if (c >= 0xF1 && c <= 0xF3) { utf8Remaining = 3; utf8Low = 0x80; utf8High = 0xBF; }
+        else if (c == 0xF4) { utf8Remaining = 3; utf8Low = 0x80; utf8High = 0x8F; }
+        else return fail();
+    }
+
+    appendString(reinterpret_cast<const char*>(&c), 1);
+    return true;
+}
+
+bool ResponseParser::numberByte(unsigned char c) {
+    switch (numberState) {
+    case NumberState::Minus:
+        if (c == '0') numberState = NumberState::Zero;
+        else if (isDigit(c)) {
+            numberState = NumberState::Integer;
+            significant[significantLength++] = static_cast<char>(c);
+        }
+        else return fail();
+        return true;
+
+    case NumberState::Zero:
+    case NumberState::Integer:
+        if (isDigit(c) && numberState == NumberState::Integer) {
+            ++decimalExponent;
+            if (significantLength < maxSignificantDigits) significant[significantLength++] = static_cast<char>(c);
+            return true;
+        }
+        if (c == '.') numberState = NumberState::FractionStart;
+        else if (c == 'e' || c == 'E') numberState = NumberState::ExponentStart;
+        else break;
+        return true;
+
+    case NumberState::FractionStart:
+    case NumberState::Fraction:
+        if (isDigit(c)) {
+            numberState = NumberState::Fraction;
+            ++fractionPosition;
+            if (significantLength == 0 && c != '0') decimalExponent = -fractionPosition;
+            if ((significantLength > 0 || c != '0') && significantLength < maxSignificantDigits)
+                significant[significantLength++] = static_cast<char>(c);
+            return true;
+        }
+        if (numberState == NumberState::FractionStart) return fail();
+        if (c == 'e' || c == 'E') {
+            numberState = NumberState::ExponentStart;
+            return true;
+        }
+        break;
+
+    case NumberState::ExponentStart:
+        if (c == '+' || c == '-') {
+            exponentNegative = c == '-';
+            numberState = NumberState::ExponentSign;
+            return true;
+        }
+        // fall through
+    case NumberState::ExponentSign:
+    case NumberState::Exponent:
+        if (isDigit(c)) {
+            numberState = NumberState::Exponent;
+            if (exponentValue < 1000000) exponentValue = exponentValue * 10 + (c - '0');
+            return true;
+        }
+        if (numberState != NumberState::Exponent) return fail();
+        break;
+    }
+
+    if (!endNumber() || !endValue()) return false;
+    return step(c);
+}
+
+bool ResponseParser::endNumber() {
+    // nlohmann::json rejects numbers that overflow a double; anything else is accepted.
+    if (significantLength == 0) return true;
+
+    long magnitude = decimalExponent + (exponentNegative ? -exponentValue : exponentValue);
+    if (magnitude < 308) return true;
+    if (magnitude > 308) return fail();
+
+    static const char largest[] = "17976931348623158079";
+    for (size_t i = 0; i < maxSignificantDigits; ++i) {
+        char digit = i < significantLength ? significant[i] : '0';
+        if (digit != largest[i]) return digit < largest[i] || fail();
+    }
+    return fail();
+}
@@ -0,0 +1,98 @@
+#ifndef LICENSE_GATE_RESPONSE_PARSER_H
+#define LICENSE_GATE_RESPONSE_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Incremental JSON parser for verify responses. Bytes are fed as they arrive; the whole body
+// is validated with the same rules as nlohmann::json::parse (RFC 8259, UTF-8, optional BOM,
+// no trailing commas, non-finite numbers rejected), but only the top-level "valid",
+// "result", "error" and "signedChallenge" members are kept, in fixed-size buffers.
+class ResponseParser {
+public:
+    enum class ValueType : uint8_t { Missing, String, True, False, Null, Number, Object, Array };
+
+    template<size_t Capacity>
+    struct Field {
+        ValueType type = ValueType::Missing;
+        bool overflow = false;
+        size_t length = 0;
+        char value[Capacity];
+
+        bool isString() const { return type == ValueType::String; }
+        bool isBoolean() const { return type == ValueType::True || type == ValueType::False; }
+        bool equals(const char* text, size_t textLength) const {
+            return !overflow && length == textLength && std::char_traits<char>::compare(value, text, textLength) == 0;
+        }
+    };
+
+    ResponseParser() { reset(); }
+
+    void reset();
+    bool feed(const char* data, size_t size);
+    bool finish();
+
+    bool failed() const { return state == State::Error; }
+    bool isObject() const { return topLevel == ValueType::Object; }
+
+    Field<8> valid;
+    Field<64> result;
+    Field<256> error;
+    Field<1024> signedChallenge;
+
+private:
+    enum class State : uint8_t {
+        Bom, Value, ValueOrArrayEnd, KeyOrObjectEnd, Key, Colon, CommaOrEnd,
+        String, Number, Literal, Done, Error
+    };
+    enum class NumberState : uint8_t { Minus, Zero, Integer, FractionStart, Fraction, ExponentStart, ExponentSign, Exponent };
+    enum class Target : uint8_t { None, Valid, Result, Error, SignedChallenge };
+
+    static constexpr size_t maxKeyLength = 16;
+    static constexpr size_t maxSignificantDigits = 20;
+
+    bool step(unsigned char c);
+    bool beginValue(unsigned char c);
+    bool endValue();
+    bool numberByte(unsigned char c);
+    bool endNumber();
+    bool stringByte(unsigned char c);
+    void appendString(const char* bytes, size_t size);
+    bool appendCodePoint(uint32_t codePoint);
+    void setType(ValueType type);
+    bool fail();
+
+    State state;
+    ValueType topLevel;
+    std::string nesting;
+
+    // string scanning
+    bool stringIsKey;
+    bool escaped;
+    uint8_t unicodeDigits;
+    uint32_t unicodeValue;
+    uint32_t highSurrogate;
+    uint8_t utf8Remaining;
+    unsigned char utf8Low;
+    unsigned char utf8High;
+    char key[maxKeyLength];
+    size_t keyLength;
+    bool keyOverflow;
+    Target target;
+    Target valueTarget;
+
+    // number and literal scanning; numbers are only checked for overflowing a double
+    NumberState numberState;
+    char significant[maxSignificantDigits];
+    size_t significantLength;
+    long decimalExponent;
+    long fractionPosition;
+    long exponentValue;
+    bool exponentNegative;
+    const char* literal;
+    uint8_t literalIndex;
+    uint8_t bomIndex;
+};
+
+#endif // LICENSE_GATE_RESPONSE_PARSER_H
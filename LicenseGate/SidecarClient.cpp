@@ -0,0 +1,146 @@
+#include "SidecarClient.hpp"
+#include "SidecarProtocol.hpp"
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+SidecarClient::SidecarClient(const Options& options) : options(options) {
+}
+
+SidecarClient::~SidecarClient() {
+    for (int fd : idle) ::close(fd);
+}
+
+SidecarClient::ValidationType SidecarClient::verify(const std::string& licenseKey) {
+    return verify(licenseKey, "", "");
+}
+
+SidecarClient::ValidationType SidecarClient::verify(const std::string& licenseKey, const std::string& scope) {
+    return verify(licenseKey, scope, "");
+}
+
+SidecarClient::ValidationType SidecarClient::verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+    const VerdictTable* current = table.load(std::memory_order_acquire);
+    int verdict;
+    if (current && !current->retired() && current->lookup(licenseKey, scope, metadata, verdict)) {
+        tableHits.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<ValidationType>(verdict);
+    }
+
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        if (!idle.empty()) {
+            fd = idle.back();
+            idle.pop_back();
+        }
+    }
+    // A pooled connection may have been closed by a daemon restart, so it gets one retry on a
+    // new connection.
+    bool pooled = fd >= 0;
+    if (!pooled) fd = connect();
+
+    ValidationType result;
+    while (fd >= 0) {
+        if (request(fd, licenseKey, scope, metadata, result)) {
+            requests.fetch_add(1, std::memory_order_relaxed);
+            release(fd);
+            return result;
+        }
+        ::close(fd);
+        fd = pooled ? connect() : -1;
+        pooled = false;
+    }
+    connectionErrors.fetch_add(1, std::memory_order_relaxed);
+    return ValidationType::CONNECTION_ERROR;
+}
+
+bool SidecarClient::verifySimple(const std::string& licenseKey) {
+    return verify(licenseKey) == ValidationType::VALID;
+}
+
+bool SidecarClient::verifySimple(const std::string& licenseKey, const std::string& scope) {
+    return verify(licenseKey, scope) == ValidationType::VALID;
+}
+
+bool SidecarClient::verifySimple(const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+    return verify(licenseKey, scope, metadata) == ValidationType::VALID;
+}
+
+bool SidecarClient::request(int fd, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType& result) {
+    thread_local std::string message;
+    message.clear();
+    if (!SidecarProtocol::encodeRequest(message, licenseKey, scope, metadata)) return false;
+
+    int32_t answer;
+    if (!SidecarProtocol::writeAll(fd, message.data(), message.size()) || !SidecarProtocol::readAll(fd, &answer, sizeof(answer))) return false;
+    if (answer < 0 || answer > static_cast<int32_t>(ValidationType::CANCELLED)) return false;
+    result = static_cast<ValidationType>(answer);
+    return true;
+}
+
+int SidecarClient::connect() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.empty() || options.socketPath.size() >= sizeof(address.sun_path)) return -1;
+    std::memcpy(address.sun_path, options.socketPath.c_str(), options.socketPath.size() + 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    timeval timeout;
+    timeout.tv_sec = static_cast<time_t>(options.timeout.count() / 1000);
+    timeout.tv_usec = static_cast<suseconds_t>((options.timeout.count() % 1000) * 1000);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    const VerdictTable* current = table.load(std::memory_order_acquire);
+    if (!options.tablePath.empty() && (!current || current->retired())) refreshTable();
+    return fd;
+}
+
+void SidecarClient::release(int fd) {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    if (idle.size() < options.poolSize) {
+        idle.push_back(fd);
+        return;
+    }
+    lock.unlock();
+    ::close(fd);
+}
+
+void SidecarClient::refreshTable() {
+    // The table is trusted only if it belongs to whoever owns the socket, i.e. the daemon.
+    struct stat socketInfo;
+    if (stat(options.socketPath.c_str(), &socketInfo) != 0) return;
+
+    std::lock_guard<std::mutex> lock(tableMutex);
+    const VerdictTable* current = table.load(std::memory_order_acquire);
+    if (current && !current->retired()) return;
+    std::unique_ptr<VerdictTable> opened = VerdictTable::open(options.tablePath, static_cast<uint32_t>(socketInfo.st_uid));
+    if (!opened || opened->retired()) return;
+    table.store(opened.get(), std::memory_order_release);
+    tables.push_back(std::move(opened));
+}
+
+SidecarClient::Stats SidecarClient::stats() const {
+    Stats stats;
+    stats.tableHits = tableHits.load(std::memory_order_relaxed);
+    stats.requests = requests.load(std::memory_order_relaxed);
+    stats.connectionErrors = connectionErrors.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,75 @@
+#ifndef LICENSE_GATE_SIDECAR_CLIENT_H
+#define LICENSE_GATE_SIDECAR_CLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LicenseGate.hpp"
+#include "VerdictTable.hpp"
+
+// Asks a SidecarServer on the same host for verdicts instead of verifying with an embedded
+// LicenseGate. A verdict found in the daemon's shared table is answered without touching the
+// socket; anything else is one request on a pooled connection. The client holds no keys,
+// connections to the license server or caches of its own. If the daemon cannot be reached,
+// verify returns CONNECTION_ERROR. POSIX only.
+class SidecarClient {
+public:
+    using ValidationType = LicenseGate::ValidationType;
+
+    struct Options {
+        std::string socketPath;
+        // Empty to always ask the daemon.
+        std::string tablePath;
+        size_t poolSize = 4;
+        std::chrono::milliseconds timeout = std::chrono::seconds(30);
+    };
+
+    struct Stats {
+        uint64_t tableHits = 0;
+        uint64_t requests = 0;
+        uint64_t connectionErrors = 0;
+    };
+
+    // One client may be shared by any number of threads.
+    explicit SidecarClient(const Options& options);
+    ~SidecarClient();
+    SidecarClient(const SidecarClient&) = delete;
+    SidecarClient& operator=(const SidecarClient&) = delete;
+
+    ValidationType verify(const std::string& licenseKey);
+    ValidationType verify(const std::string& licenseKey, const std::string& scope);
+    ValidationType verify(const std::string& licenseKey, const std::string& scope, const std::string& metadata);
+
+    bool verifySimple(const std::string& licenseKey);
+    bool verifySimple(const std::string& licenseKey, const std::string& scope);
+    bool verifySimple(const std::string& licenseKey, const std::string& scope, const std::string& metadata);
+
+    Stats stats() const;
+
+private:
+    int connect();
+    void release(int fd);
+    bool request(int fd, const std::string& licenseKey, const std::string& scope, const std::string& metadata, ValidationType& result);
+    // Maps the table again after the daemon has restarted. Replaced tables stay mapped until the
+    // client is destroyed, since readers may still be looking at them.
+    void refreshTable();
+
+    const Options options;
+
+    std::mutex idleMutex;
+    std::vector<int> idle;
+
+    std::mutex tableMutex;
+    std::vector<std::unique_ptr<VerdictTable>> tables;
+    std::atomic<const VerdictTable*> table{ nullptr };
+
+    std::atomic<uint64_t> tableHits{ 0 };
+    std::atomic<uint64_t> requests{ 0 };
+    std::atomic<uint64_t> connectionErrors{ 0 };
+};
+
+#endif // LICENSE_GATE_SIDECAR_CLIENT_H
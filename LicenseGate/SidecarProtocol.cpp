@@ -0,0 +1,48 @@
+#include "SidecarProtocol.hpp"
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS sets SO_NOSIGPIPE on the socket instead
+#endif
+
+namespace SidecarProtocol {
+    bool encodeRequest(std::string& out, const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+        if (licenseKey.size() > maxFieldLength || scope.size() > maxFieldLength || metadata.size() > maxFieldLength) return false;
+
+        RequestHeader header;
+        header.magic = requestMagic;
+        header.licenseKeyLength = static_cast<uint32_t>(licenseKey.size());
+        header.scopeLength = static_cast<uint32_t>(scope.size());
+        header.metadataLength = static_cast<uint32_t>(metadata.size());
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(licenseKey).append(scope).append(metadata);
+        return true;
+    }
+
+    bool readAll(int fd, void* data, size_t size) {
+        char* cursor = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t received = ::recv(fd, cursor, size, 0);
+            if (received < 0 && errno == EINTR) continue;
+            if (received <= 0) return false;
+            cursor += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* cursor = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t sent = ::send(fd, cursor, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            cursor += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+}
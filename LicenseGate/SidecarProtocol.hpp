@@ -0,0 +1,30 @@
+#ifndef LICENSE_GATE_SIDECAR_PROTOCOL_H
+#define LICENSE_GATE_SIDECAR_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Framing between SidecarClient and SidecarServer. Both ends run on the same host, so integers
+// are sent in native byte order. A request is a header followed by the license key, scope and
+// metadata; the answer is one int32 holding a LicenseGate::ValidationType.
+namespace SidecarProtocol {
+    constexpr uint32_t requestMagic = 0x5152474c; // "LGRQ"
+    constexpr uint32_t maxFieldLength = 64 * 1024;
+
+    struct RequestHeader {
+        uint32_t magic;
+        uint32_t licenseKeyLength;
+        uint32_t scopeLength;
+        uint32_t metadataLength;
+    };
+
+    // Appends a whole request to out, so that it can be sent with one write.
+    bool encodeRequest(std::string& out, const std::string& licenseKey, const std::string& scope, const std::string& metadata);
+
+    // Both retry on EINTR and return false once the peer has gone or the socket timed out.
+    bool readAll(int fd, void* data, size_t size);
+    bool writeAll(int fd, const void* data, size_t size);
+}
+
+#endif // LICENSE_GATE_SIDECAR_PROTOCOL_H
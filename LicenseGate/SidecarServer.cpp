@@ -0,0 +1,176 @@
+#include "SidecarServer.hpp"
+#include "SidecarProtocol.hpp"
+#include "XorStr.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+SidecarServer::SidecarServer(LicenseGate& gate, const Options& options) : gate(gate), options(options) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.empty() || options.socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error(xorstr_("Sidecar socket path is empty or too long"));
+    std::memcpy(address.sun_path, options.socketPath.c_str(), options.socketPath.size() + 1);
+
+    if (!options.tablePath.empty()) {
+        table = VerdictTable::create(options.tablePath, options.tableSlots, options.tableMode);
+        if (!table) throw std::runtime_error(xorstr_("Failed to create the sidecar verdict table"));
+    }
+
+    // Only a stale socket is removed; any other file at the path is left for the user to sort out.
+    struct stat existing;
+    if (lstat(options.socketPath.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) ::unlink(options.socketPath.c_str());
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || pipe(wakeFds) != 0) {
+        if (listenFd >= 0) ::close(listenFd);
+        throw std::runtime_error(xorstr_("Failed to create the sidecar socket"));
+    }
+    fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+    fcntl(wakeFds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(wakeFds[1], F_SETFD, FD_CLOEXEC);
+
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || chmod(options.socketPath.c_str(), static_cast<mode_t>(options.socketMode)) != 0 || ::listen(listenFd, 128) != 0) {
+        int error = errno;
+        ::close(listenFd);
+        ::close(wakeFds[0]);
+        ::close(wakeFds[1]);
+        throw std::runtime_error(std::string(xorstr_("Failed to listen on the sidecar socket: ")) + std::strerror(error));
+    }
+}
+
+SidecarServer::~SidecarServer() {
+    ::close(listenFd);
+    ::unlink(options.socketPath.c_str());
+    ::close(wakeFds[0]);
+    ::close(wakeFds[1]);
+}
+
+void SidecarServer::run() {
+    pollfd fds[2] = { { listenFd, POLLIN, 0 }, { wakeFds[0], POLLIN, 0 } };
+    for (;;) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        reapFinished();
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        if (connections.size() >= options.maxConnections) {
+            rejectedConnections.fetch_add(1, std::memory_order_relaxed);
+            ::close(fd);
+            continue;
+        }
+        connectionCount.fetch_add(1, std::memory_order_relaxed);
+        connections.emplace_back(new Connection());
+        Connection& connection = *connections.back();
+        connection.fd = fd;
+        connection.thread = std::thread([this, &connection]() { serve(connection); });
+    }
+
+    // Wake every connection thread blocked in recv; each fd is closed only after its thread is joined.
+    std::list<std::unique_ptr<Connection>> closing;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        closing.swap(connections);
+    }
+    for (auto& connection : closing) ::shutdown(connection->fd, SHUT_RDWR);
+    for (auto& connection : closing) {
+        connection->thread.join();
+        ::close(connection->fd);
+    }
+}
+
+void SidecarServer::stop() {
+    char wake = 1;
+    while (::write(wakeFds[1], &wake, 1) < 0 && errno == EINTR) {}
+}
+
+void SidecarServer::reapFinished() {
+    std::list<std::unique_ptr<Connection>> finished;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (auto it = connections.begin(); it != connections.end();) {
+            if ((*it)->finished.load(std::memory_order_acquire)) finished.splice(finished.end(), connections, it++);
+            else ++it;
+        }
+    }
+    for (auto& connection : finished) {
+        connection->thread.join();
+        ::close(connection->fd);
+    }
+}
+
+void SidecarServer::serve(Connection& connection) {
+    std::string licenseKey;
+    std::string scope;
+    std::string metadata;
+    SidecarProtocol::RequestHeader header;
+
+    while (SidecarProtocol::readAll(connection.fd, &header, sizeof(header))) {
+        if (header.magic != SidecarProtocol::requestMagic || header.licenseKeyLength > SidecarProtocol::maxFieldLength
+            || header.scopeLength > SidecarProtocol::maxFieldLength || header.metadataLength > SidecarProtocol::maxFieldLength) break;
+
+        licenseKey.resize(header.licenseKeyLength);
+        scope.resize(header.scopeLength);
+        metadata.resize(header.metadataLength);
+        if (!SidecarProtocol::readAll(connection.fd, &licenseKey[0], licenseKey.size()) || !SidecarProtocol::readAll(connection.fd, &scope[0], scope.size())
+            || !SidecarProtocol::readAll(connection.fd, &metadata[0], metadata.size())) break;
+
+        requests.fetch_add(1, std::memory_order_relaxed);
+        LicenseGate::ValidationType result = gate.verify(licenseKey, scope, metadata);
+        publish(licenseKey, scope, metadata, result);
+
+        int32_t answer = static_cast<int32_t>(result);
+        if (!SidecarProtocol::writeAll(connection.fd, &answer, sizeof(answer))) break;
+    }
+    connection.finished.store(true, std::memory_order_release);
+}
+
+void SidecarServer::publish(const std::string& licenseKey, const std::string& scope, const std::string& metadata, LicenseGate::ValidationType result) {
+    if (!table) return;
+
+    std::chrono::milliseconds ttl;
+    switch (result) {
+    case LicenseGate::ValidationType::VALID:
+        ttl = options.validTtl;
+        break;
+    case LicenseGate::ValidationType::NOT_FOUND:
+    case LicenseGate::ValidationType::NOT_ACTIVE:
+    case LicenseGate::ValidationType::EXPIRED:
+        ttl = options.negativeTtl;
+        break;
+    default:
+        return;
+    }
+    if (ttl.count() <= 0) return;
+    table->store(licenseKey, scope, metadata, static_cast<int>(result), VerdictTable::Clock::now() + ttl);
+    published.fetch_add(1, std::memory_order_relaxed);
+}
+
+SidecarServer::Stats SidecarServer::stats() const {
+    Stats stats;
+    stats.connections = connectionCount.load(std::memory_order_relaxed);
+    stats.rejectedConnections = rejectedConnections.load(std::memory_order_relaxed);
+    stats.requests = requests.load(std::memory_order_relaxed);
+    stats.published = published.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,81 @@
+#ifndef LICENSE_GATE_SIDECAR_SERVER_H
+#define LICENSE_GATE_SIDECAR_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "LicenseGate.hpp"
+#include "VerdictTable.hpp"
+
+// Answers SidecarClient requests on a Unix domain socket with one shared LicenseGate, so that
+// every process on a host shares its connections, keys and request coalescing. Each answer
+// the client could cache is also published in a VerdictTable, from which clients answer
+// repeated lookups without asking again. Each connection is served by its own thread. POSIX only.
+class SidecarServer {
+public:
+    struct Options {
+        std::string socketPath;
+        // Empty for no shared table.
+        std::string tablePath;
+        size_t tableSlots = 16384;
+        // How long a published verdict is used; counted from when the daemon answered.
+        std::chrono::milliseconds validTtl = std::chrono::minutes(5);
+        std::chrono::milliseconds negativeTtl = std::chrono::minutes(1);
+        // Who may connect is decided by the socket's permissions, and who may read the table
+        // by the table's. Clients that use the table must be in its group, like the socket's.
+        uint32_t socketMode = 0660;
+        uint32_t tableMode = 0640;
+        size_t maxConnections = 1024;
+    };
+
+    struct Stats {
+        uint64_t connections = 0;
+        uint64_t rejectedConnections = 0;
+        uint64_t requests = 0;
+        uint64_t published = 0;
+    };
+
+    // Binds the socket and creates the table; throws std::runtime_error if either fails.
+    SidecarServer(LicenseGate& gate, const Options& options);
+    ~SidecarServer();
+    SidecarServer(const SidecarServer&) = delete;
+    SidecarServer& operator=(const SidecarServer&) = delete;
+
+    // Serves until stop() is called from another thread, then closes every connection.
+    void run();
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> finished{ false };
+    };
+
+    void serve(Connection& connection);
+    void publish(const std::string& licenseKey, const std::string& scope, const std::string& metadata, LicenseGate::ValidationType result);
+    void reapFinished();
+
+    LicenseGate& gate;
+    const Options options;
+    std::unique_ptr<VerdictTable> table;
+    int listenFd = -1;
+    int wakeFds[2] = { -1, -1 };
+
+    std::mutex connectionsMutex;
+    std::list<std::unique_ptr<Connection>> connections;
+
+    std::atomic<uint64_t> connectionCount{ 0 };
+    std::atomic<uint64_t> rejectedConnections{ 0 };
+    std::atomic<uint64_t> requests{ 0 };
+    std::atomic<uint64_t> published{ 0 };
+};
+
+#endif // LICENSE_GATE_SIDECAR_SERVER_H
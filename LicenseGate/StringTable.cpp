@@ -0,0 +1,126 @@
+#include "StringTable.hpp"
+#include "XorStr.hpp"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t literalCount = static_cast<size_t>(StringTable::Literal::Count);
+
+    // One locked data page between two guard pages. Returns nullptr if the page cannot be
+    // mapped, in which case the table lives in ordinary static storage.
+    char* mapProtectedPage(size_t& pageSize) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        pageSize = info.dwPageSize;
+
+        char* base = static_cast<char*>(VirtualAlloc(NULL, pageSize * 3, MEM_RESERVE | MEM_COMMIT, PAGE_NOACCESS));
+        if (!base) return nullptr;
+        char* data = base + pageSize;
+        DWORD previous;
+        if (!VirtualProtect(data, pageSize, PAGE_READWRITE, &previous)) {
+            VirtualFree(base, 0, MEM_RELEASE);
+            return nullptr;
+        }
+        VirtualLock(data, pageSize);
+        return data;
+#else
+        pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+        void* base = mmap(nullptr, pageSize * 3, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) return nullptr;
+        char* data = static_cast<char*>(base) + pageSize;
+        if (mprotect(data, pageSize, PROT_READ | PROT_WRITE) != 0) {
+            munmap(base, pageSize * 3);
+            return nullptr;
+        }
+        // Best effort: without CAP_IPC_LOCK the RLIMIT_MEMLOCK budget may be exhausted.
+        mlock(data, pageSize);
+#ifdef MADV_DONTDUMP
+        madvise(data, pageSize, MADV_DONTDUMP);
+#endif
+        return data;
+#endif
+    }
+
+    void makeReadOnly(char* data, size_t pageSize) {
+#ifdef _WIN32
+        DWORD previous;
+        VirtualProtect(data, pageSize, PAGE_READONLY, &previous);
+#else
+        mprotect(data, pageSize, PROT_READ);
+#endif
+    }
+}
+
+struct StringTable::Region {
+    const char* data = nullptr;
+    uint16_t offsets[literalCount] = {};
+    uint16_t lengths[literalCount] = {};
+};
+
+std::string_view StringTable::get(Literal literal) {
+    const Region& table = region();
+    size_t index = static_cast<size_t>(literal);
+    return std::string_view(table.data + table.offsets[index], table.lengths[index]);
+}
+
+const StringTable::Region& StringTable::region() {
+    static const Region table = []() {
+        static char fallback[1024];
+
+        size_t pageSize = sizeof(fallback);
+        char* data = mapProtectedPage(pageSize);
+        bool mapped = data != nullptr;
+        if (!mapped) {
+            data = fallback;
+            pageSize = sizeof(fallback);
+        }
+
+        Region built;
+        built.data = data;
+        size_t used = 0;
+        auto put = [&](Literal literal, const char* text) {
+            size_t length = std::strlen(text);
+            if (used + length > pageSize) return;
+            std::memcpy(data + used, text, length);
+            built.offsets[static_cast<size_t>(literal)] = static_cast<uint16_t>(used);
+            built.lengths[static_cast<size_t>(literal)] = static_cast<uint16_t>(length);
+            used += length;
+        };
+
+        put(Literal::QueryMetadata, xorstr_("metadata="));
+        put(Literal::QueryScope, xorstr_("scope="));
+        put(Literal::QueryChallenge, xorstr_("challenge="));
+        put(Literal::QueryFirst, xorstr_("?"));
+        put(Literal::QueryNext, xorstr_("&"));
+        put(Literal::LicensePath, xorstr_("/license/"));
+        put(Literal::PathSeparator, xorstr_("/"));
+        put(Literal::VerifyPath, xorstr_("/verify"));
+        put(Literal::KeyValid, xorstr_("valid"));
+        put(Literal::KeyResult, xorstr_("result"));
+        put(Literal::KeyError, xorstr_("error"));
+        put(Literal::KeySignedChallenge, xorstr_("signedChallenge"));
+        put(Literal::ResultValid, xorstr_("VALID"));
+        put(Literal::ResultNotFound, xorstr_("NOT_FOUND"));
+        put(Literal::ResultNotActive, xorstr_("NOT_ACTIVE"));
+        put(Literal::ResultExpired, xorstr_("EXPIRED"));
+        put(Literal::ResultLicenseScopeFailed, xorstr_("LICENSE_SCOPE_FAILED"));
+        put(Literal::ResultIpLimitExceeded, xorstr_("IP_LIMIT_EXCEEDED"));
+        put(Literal::ResultRateLimitExceeded, xorstr_("RATE_LIMIT_EXCEEDED"));
+        put(Literal::ResultFailedChallenge, xorstr_("FAILED_CHALLENGE"));
+        put(Literal::ResultServerError, xorstr_("SERVER_ERROR"));
+
+        if (mapped) makeReadOnly(data, pageSize);
+        return built;
+    }();
+    return table;
+}
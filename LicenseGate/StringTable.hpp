@@ -0,0 +1,45 @@
+#ifndef LICENSE_GATE_STRING_TABLE_H
+#define LICENSE_GATE_STRING_TABLE_H
+
+#include <cstdint>
+#include <string_view>
+
+// The literals used on every verification. They are compiled in encrypted with XorStr, like
+// every other literal, but decrypted only once, on first use, into a page that is locked in
+// memory, made read-only afterwards and surrounded by inaccessible guard pages.
+class StringTable {
+public:
+    enum class Literal : uint8_t {
+        QueryMetadata,      // "metadata="
+        QueryScope,         // "scope="
+        QueryChallenge,     // "challenge="
+        QueryFirst,         // "?"
+        QueryNext,          // "&"
+        LicensePath,        // "/license/"
+        PathSeparator,      // "/"
+        VerifyPath,         // "/verify"
+        KeyValid,           // "valid"
+        KeyResult,          // "result"
+        KeyError,           // "error"
+        KeySignedChallenge, // "signedChallenge"
+        // server result codes, in ValidationType order
+        ResultValid,
+        ResultNotFound,
+        ResultNotActive,
+        ResultExpired,
+        ResultLicenseScopeFailed,
+        ResultIpLimitExceeded,
+        ResultRateLimitExceeded,
+        ResultFailedChallenge,
+        ResultServerError,
+        Count
+    };
+
+    static std::string_view get(Literal literal);
+
+private:
+    struct Region;
+    static const Region& region();
+};
+
+#endif // LICENSE_GATE_STRING_TABLE_H
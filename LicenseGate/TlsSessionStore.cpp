@@ -0,0 +1,222 @@
+#include "TlsSessionStore.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <openssl/ssl.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t fileMagic = 0x5354474c; // "LGTS"
+    constexpr size_t maxHostLength = 255;
+    constexpr size_t maxSessionLength = 16 * 1024;
+    constexpr size_t maxSessions = 64;
+
+    using NewSessionCallback = int (*)(SSL*, SSL_SESSION*);
+    using InfoCallback = void (*)(const SSL*, int, int);
+
+    // libcurl installs the same callbacks on every context it creates, so one copy is enough.
+    std::atomic<NewSessionCallback> curlNewSession{ nullptr };
+    std::atomic<InfoCallback> previousInfo{ nullptr };
+
+    int storeIndex() {
+        static const int index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+        return index;
+    }
+
+    TlsSessionStore* storeOf(const SSL* ssl) {
+        return static_cast<TlsSessionStore*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), storeIndex()));
+    }
+
+    int onNewSession(SSL* ssl, SSL_SESSION* session) {
+        TlsSessionStore* store = storeOf(ssl);
+        const char* host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+        if (store && host && SSL_SESSION_is_resumable(session)) {
+            int length = i2d_SSL_SESSION(session, NULL);
+            if (length > 0 && static_cast<size_t>(length) <= maxSessionLength) {
+                std::vector<unsigned char> encoded(static_cast<size_t>(length));
+                unsigned char* out = encoded.data();
+                i2d_SSL_SESSION(session, &out);
+
+                int64_t expiresAt = static_cast<int64_t>(SSL_SESSION_get_time(session)) + SSL_SESSION_get_timeout(session);
+                unsigned long hint = SSL_SESSION_get_ticket_lifetime_hint(session);
+                if (hint > 0) expiresAt = std::min<int64_t>(expiresAt, static_cast<int64_t>(SSL_SESSION_get_time(session)) + static_cast<int64_t>(hint));
+                store->remember(host, encoded.data(), encoded.size(), expiresAt);
+            }
+        }
+
+        // The return value tells OpenSSL whether the callback kept a reference; that is up to libcurl.
+        NewSessionCallback next = curlNewSession.load(std::memory_order_acquire);
+        return next ? next(ssl, session) : 0;
+    }
+
+    // Offers a stored session when libcurl has none of its own for this connection. The
+    // server name is already set by then, and the ClientHello not yet built.
+    void onInfo(const SSL* constSsl, int where, int ret) {
+        InfoCallback next = previousInfo.load(std::memory_order_acquire);
+        if (next) next(constSsl, where, ret);
+        if (!(where & SSL_CB_HANDSHAKE_START)) return;
+
+        SSL* ssl = const_cast<SSL*>(constSsl);
+        if (SSL_get_session(ssl)) return;
+        TlsSessionStore* store = storeOf(ssl);
+        const char* host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+        if (!store || !host) return;
+
+        std::vector<unsigned char> encoded;
+        if (!store->lookup(host, encoded)) return;
+        const unsigned char* in = encoded.data();
+        SSL_SESSION* session = d2i_SSL_SESSION(NULL, &in, static_cast<long>(encoded.size()));
+        if (!session) return;
+        SSL_set_session(ssl, session);
+        SSL_SESSION_free(session);
+    }
+
+    CURLcode onSslContext(CURL*, void* sslContext, void* userptr) {
+        SSL_CTX* context = static_cast<SSL_CTX*>(sslContext);
+        SSL_CTX_set_ex_data(context, storeIndex(), userptr);
+
+        NewSessionCallback existing = SSL_CTX_sess_get_new_cb(context);
+        if (existing && existing != onNewSession) curlNewSession.store(existing, std::memory_order_release);
+        SSL_CTX_set_session_cache_mode(context, SSL_CTX_get_session_cache_mode(context) | SSL_SESS_CACHE_CLIENT);
+        SSL_CTX_sess_set_new_cb(context, onNewSession);
+
+        InfoCallback info = SSL_CTX_get_info_callback(context);
+        if (info && info != onInfo) previousInfo.store(info, std::memory_order_release);
+        SSL_CTX_set_info_callback(context, onInfo);
+        return CURLE_OK;
+    }
+
+    bool readAll(std::FILE* in, void* data, size_t size) {
+        return std::fread(data, 1, size, in) == size;
+    }
+
+    bool writeAll(std::FILE* out, const void* data, size_t size) {
+        return std::fwrite(data, 1, size, out) == size;
+    }
+}
+
+TlsSessionStore::TlsSessionStore(std::string path) : path(std::move(path)) {
+    load();
+}
+
+size_t TlsSessionStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sessions.size();
+}
+
+bool TlsSessionStore::attach(CURL* handle) {
+    return curl_easy_setopt(handle, CURLOPT_SSL_CTX_FUNCTION, onSslContext) == CURLE_OK
+        && curl_easy_setopt(handle, CURLOPT_SSL_CTX_DATA, this) == CURLE_OK;
+}
+
+bool TlsSessionStore::lookup(const std::string& host, std::vector<unsigned char>& session) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sessions.find(host);
+    if (it == sessions.end()) return false;
+    if (it->second.expiresAt <= static_cast<int64_t>(std::time(nullptr))) {
+        sessions.erase(it);
+        return false;
+    }
+    session = it->second.session;
+    return true;
+}
+
+void TlsSessionStore::remember(const std::string& host, const unsigned char* session, size_t length, int64_t expiresAt) {
+    if (host.size() > maxHostLength || length > maxSessionLength) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sessions.size() >= maxSessions && sessions.find(host) == sessions.end()) return;
+    Entry& entry = sessions[host];
+    entry.session.assign(session, session + length);
+    entry.expiresAt = expiresAt;
+    save();
+}
+
+void TlsSessionStore::load() {
+#ifdef _WIN32
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) return;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+        ::close(fd);
+        return;
+    }
+    std::FILE* in = fdopen(fd, "rb");
+    if (!in) {
+        ::close(fd);
+        return;
+    }
+#endif
+
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    uint32_t magic = 0;
+    if (readAll(in, &magic, sizeof(magic)) && magic == fileMagic) {
+        uint16_t hostLength;
+        while (sessions.size() < maxSessions && readAll(in, &hostLength, sizeof(hostLength)) && hostLength <= maxHostLength) {
+            std::string host(hostLength, '\0');
+            uint32_t sessionLength;
+            if (!readAll(in, &host[0], hostLength) || !readAll(in, &sessionLength, sizeof(sessionLength)) || sessionLength > maxSessionLength) break;
+            Entry entry;
+            entry.session.resize(sessionLength);
+            if (!readAll(in, entry.session.data(), sessionLength) || !readAll(in, &entry.expiresAt, sizeof(entry.expiresAt))) break;
+            if (entry.expiresAt > now) sessions[host] = std::move(entry);
+        }
+    }
+    std::fclose(in);
+}
+
+// Called with the mutex held. Writes the whole file next to the old one and renames it over.
+void TlsSessionStore::save() {
+    std::string temporaryPath = path + ".tmp";
+#ifdef _WIN32
+    std::FILE* out = std::fopen(temporaryPath.c_str(), "wb");
+    if (!out) return;
+#else
+    ::unlink(temporaryPath.c_str());
+    int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+    if (fd < 0) return;
+    std::FILE* out = fdopen(fd, "wb");
+    if (!out) {
+        ::close(fd);
+        return;
+    }
+#endif
+
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    bool written = writeAll(out, &fileMagic, sizeof(fileMagic));
+    for (const auto& entry : sessions) {
+        if (entry.second.expiresAt <= now) continue;
+        uint16_t hostLength = static_cast<uint16_t>(entry.first.size());
+        uint32_t sessionLength = static_cast<uint32_t>(entry.second.session.size());
+        written = written && writeAll(out, &hostLength, sizeof(hostLength)) && writeAll(out, entry.first.data(), hostLength)
+            && writeAll(out, &sessionLength, sizeof(sessionLength)) && writeAll(out, entry.second.session.data(), sessionLength)
+            && writeAll(out, &entry.second.expiresAt, sizeof(entry.second.expiresAt));
+    }
+    written = std::fflush(out) == 0 && written;
+    std::fclose(out);
+    if (!written) {
+        std::remove(temporaryPath.c_str());
+        return;
+    }
+
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) std::remove(temporaryPath.c_str());
+}
@@ -0,0 +1,46 @@
+#ifndef LICENSE_GATE_TLS_SESSION_STORE_H
+#define LICENSE_GATE_TLS_SESSION_STORE_H
+
+#include <curl/curl.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// TLS sessions kept in a file, so that a restarted process can resume its session with the
+// validation server instead of doing a full handshake. Sessions are captured and offered
+// through the OpenSSL context of each connection; with a libcurl built on another TLS
+// backend the store is simply never used. The file holds session secrets and a resumed
+// session skips certificate verification, so on POSIX systems it is written owner-only and
+// ignored unless it belongs to the current user and nobody else can write to it. Keep it in
+// a directory only the user can write to, such as the user's cache directory.
+class TlsSessionStore {
+public:
+    explicit TlsSessionStore(std::string path);
+
+    const std::string& getPath() const { return path; }
+    size_t size() const;
+
+    // Sets CURLOPT_SSL_CTX_FUNCTION on the handle; false if curl's TLS backend lacks it.
+    bool attach(CURL* handle);
+
+    // Used by the OpenSSL callbacks. Sessions are keyed on the server name sent in SNI.
+    bool lookup(const std::string& host, std::vector<unsigned char>& session);
+    void remember(const std::string& host, const unsigned char* session, size_t length, int64_t expiresAt);
+
+private:
+    struct Entry {
+        std::vector<unsigned char> session;
+        int64_t expiresAt = 0;
+    };
+
+    void load();
+    void save();
+
+    std::string path;
+    mutable std::mutex mutex;
+    std::map<std::string, Entry> sessions;
+};
+
+#endif // LICENSE_GATE_TLS_SESSION_STORE_H
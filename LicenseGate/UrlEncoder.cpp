@@ -0,0 +1,76 @@
+#include "UrlEncoder.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LICENSE_GATE_URL_ENCODER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+#ifdef LICENSE_GATE_URL_ENCODER_SSE2
+    // One bit per byte of the block, set where the byte is unreserved. Bytes >= 0x80 are
+    // negative as signed chars and so fall outside every range.
+    unsigned unreservedMask(__m128i block) {
+        auto between = [&](char low, char high) {
+            return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8(high + 1)));
+        };
+        __m128i upper = between('A', 'Z');
+        __m128i lower = between('a', 'z');
+        __m128i digit = between('0', '9');
+        __m128i marks = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('-')), _mm_cmpeq_epi8(block, _mm_set1_epi8('.'))),
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')), _mm_cmpeq_epi8(block, _mm_set1_epi8('~'))));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, marks))));
+    }
+
+    unsigned countTrailingOnes(unsigned mask) {
+        unsigned count = 0;
+        while (mask & 1u) {
+            mask >>= 1;
+            ++count;
+        }
+        return count;
+    }
+#endif
+}
+
+void UrlEncoder::append(std::string& out, std::string_view text) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    size_t start = out.size();
+    out.resize(start + text.size() * 3);
+    char* dst = &out[start];
+    const char* src = text.data();
+    const char* end = src + text.size();
+
+    while (src < end) {
+#ifdef LICENSE_GATE_URL_ENCODER_SSE2
+        if (end - src >= 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            unsigned mask = unreservedMask(block);
+            if (mask == 0xFFFF) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), block);
+                src += 16;
+                dst += 16;
+                continue;
+            }
+            unsigned run = countTrailingOnes(mask);
+            std::memcpy(dst, src, run);
+            src += run;
+            dst += run;
+        }
+#endif
+        unsigned char c = static_cast<unsigned char>(*src++);
+        if (isUnreserved(c)) {
+            *dst++ = static_cast<char>(c);
+        }
+        else {
+            dst[0] = '%';
+            dst[1] = hex[c >> 4];
+            dst[2] = hex[c & 0x0F];
+            dst += 3;
+        }
+    }
+
+    out.resize(dst - out.data());
+}
@@ -0,0 +1,21 @@
+#ifndef LICENSE_GATE_URL_ENCODER_H
+#define LICENSE_GATE_URL_ENCODER_H
+
+#include <string>
+#include <string_view>
+
+// Percent-encoding with the same output as curl_easy_escape: ALPHA, DIGIT, '-', '.', '_' and
+// '~' are copied, every other byte becomes %XX with upper-case hex digits. Runs of unreserved
+// characters are copied 16 bytes at a time where SSE2 is available.
+class UrlEncoder {
+public:
+    // Appends the encoded text; allocates only if out lacks the capacity for it.
+    static void append(std::string& out, std::string_view text);
+
+    static bool isUnreserved(unsigned char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')
+            || c == '-' || c == '.' || c == '_' || c == '~';
+    }
+};
+
+#endif // LICENSE_GATE_URL_ENCODER_H
@@ -0,0 +1,124 @@
+#include "VerdictCache.hpp"
+#include <cstring>
+
+VerdictCache::VerdictCache(const Options& options) : options(options) {
+    if (this->options.shardCount == 0) this->options.shardCount = 1;
+    shardBudget = this->options.maxBytes / this->options.shardCount;
+    shards.reset(new Shard[this->options.shardCount]);
+}
+
+uint64_t VerdictCache::hashKey(const std::string& userId, const std::string& licenseKey,
+    const std::string& scope, const std::string& metadata) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string* part : { &userId, &licenseKey, &scope, &metadata }) {
+        for (unsigned char c : *part) hash = (hash ^ c) * 1099511628211ull;
+        hash = (hash ^ 0xff) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool VerdictCache::keyEquals(const std::string& key, const std::string& userId, const std::string& licenseKey,
+    const std::string& scope, const std::string& metadata) {
+    if (key.size() != userId.size() + licenseKey.size() + scope.size() + metadata.size() + 3) return false;
+
+    const char* cursor = key.data();
+    for (const std::string* part : { &userId, &licenseKey, &scope, &metadata }) {
+        if (std::memcmp(cursor, part->data(), part->size()) != 0) return false;
+        cursor += part->size() + 1;
+    }
+    return true;
+}
+
+size_t VerdictCache::entryBytes(const Entry& entry) {
+    // list node, hash bucket and string heap block, approximately
+    return sizeof(Entry) + entry.key.capacity() + 4 * sizeof(void*) + 32;
+}
+
+bool VerdictCache::lookup(const std::string& userId, const std::string& licenseKey, const std::string& scope,
+    const std::string& metadata, int& verdict) {
+    uint64_t hash = hashKey(userId, licenseKey, scope, metadata);
+    Shard& shard = shardFor(hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(hash);
+    if (found == shard.index.end() || !keyEquals(found->second->key, userId, licenseKey, scope, metadata)) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (found->second->expiresAt <= Clock::now()) {
+        erase(shard, found->second);
+        expirations.fetch_add(1, std::memory_order_relaxed);
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+    verdict = found->second->verdict;
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void VerdictCache::store(const std::string& userId, const std::string& licenseKey, const std::string& scope,
+    const std::string& metadata, int verdict, std::chrono::milliseconds ttl) {
+    uint64_t hash = hashKey(userId, licenseKey, scope, metadata);
+    Shard& shard = shardFor(hash);
+    Clock::time_point expiresAt = Clock::now() + ttl;
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(hash);
+    if (found != shard.index.end()) {
+        if (keyEquals(found->second->key, userId, licenseKey, scope, metadata)) {
+            found->second->verdict = verdict;
+            found->second->expiresAt = expiresAt;
+            shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+            return;
+        }
+        erase(shard, found->second);
+    }
+
+    std::string key;
+    key.reserve(userId.size() + licenseKey.size() + scope.size() + metadata.size() + 3);
+    key.append(userId).push_back('\0');
+    key.append(licenseKey).push_back('\0');
+    key.append(scope).push_back('\0');
+    key.append(metadata);
+
+    shard.lru.push_front(Entry{ hash, std::move(key), verdict, expiresAt });
+    shard.index.emplace(hash, shard.lru.begin());
+    shard.bytes += entryBytes(shard.lru.front());
+
+    while (shard.bytes > shardBudget && shard.lru.size() > 1) {
+        erase(shard, std::prev(shard.lru.end()));
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void VerdictCache::erase(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= entryBytes(*it);
+    shard.index.erase(it->hash);
+    shard.lru.erase(it);
+}
+
+void VerdictCache::clear() {
+    for (size_t i = 0; i < options.shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        shards[i].index.clear();
+        shards[i].lru.clear();
+        shards[i].bytes = 0;
+    }
+}
+
+VerdictCache::Stats VerdictCache::stats() const {
+    Stats result;
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.misses = misses.load(std::memory_order_relaxed);
+    result.evictions = evictions.load(std::memory_order_relaxed);
+    result.expirations = expirations.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < options.shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        result.entries += shards[i].lru.size();
+        result.bytes += shards[i].bytes;
+    }
+    return result;
+}
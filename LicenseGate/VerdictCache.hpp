@@ -0,0 +1,81 @@
+#ifndef LICENSE_GATE_VERDICT_CACHE_H
+#define LICENSE_GATE_VERDICT_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Verdicts keyed on (userId, licenseKey, scope, metadata), split across independently locked
+// shards. Each shard evicts least recently used entries once it goes over its share of the
+// memory cap. Lookups hash the key parts in place, so a hit does not allocate.
+class VerdictCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        size_t shardCount = 16;
+        size_t maxBytes = 4 * 1024 * 1024;
+        std::chrono::milliseconds validTtl = std::chrono::minutes(5);
+        std::chrono::milliseconds negativeTtl = std::chrono::minutes(1);
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t expirations = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    explicit VerdictCache(const Options& options);
+
+    static uint64_t hashKey(const std::string& userId, const std::string& licenseKey,
+        const std::string& scope, const std::string& metadata);
+
+    bool lookup(const std::string& userId, const std::string& licenseKey, const std::string& scope,
+        const std::string& metadata, int& verdict);
+    void store(const std::string& userId, const std::string& licenseKey, const std::string& scope,
+        const std::string& metadata, int verdict, std::chrono::milliseconds ttl);
+    void clear();
+
+    const Options& getOptions() const { return options; }
+    Stats stats() const;
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::string key;
+        int verdict;
+        Clock::time_point expiresAt;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    static bool keyEquals(const std::string& key, const std::string& userId, const std::string& licenseKey,
+        const std::string& scope, const std::string& metadata);
+    static size_t entryBytes(const Entry& entry);
+
+    Shard& shardFor(uint64_t hash) { return shards[(hash >> 32) % options.shardCount]; }
+    void erase(Shard& shard, std::list<Entry>::iterator it);
+
+    Options options;
+    size_t shardBudget;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> misses{ 0 };
+    std::atomic<uint64_t> evictions{ 0 };
+    std::atomic<uint64_t> expirations{ 0 };
+};
+
+#endif // LICENSE_GATE_VERDICT_CACHE_H
@@ -0,0 +1,289 @@
+#include "VerdictStore.hpp"
+#include <openssl/evp.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t recordMagic = 0x3247564c; // "LVG2"; "LVGS" records had no key digest
+    constexpr size_t compactThreshold = 1024;
+}
+
+static_assert(sizeof(VerdictStore::Record) == 1024, "VerdictStore::Record must stay 1 KiB");
+
+VerdictStore::VerdictStore(const Options& options) : options(options) {
+    if (!openFile(options.path)) return;
+    if (mappedCount >= compactThreshold && mappedIndex.size() * 2 < mappedCount) compact();
+}
+
+VerdictStore::~VerdictStore() {
+    unmapFile();
+    closeFile();
+}
+
+uint32_t VerdictStore::checksumOf(const Record& record) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record) + offsetof(Record, keyHash);
+    const unsigned char* end = reinterpret_cast<const unsigned char*>(&record) + sizeof(Record);
+    uint32_t hash = 2166136261u;
+    for (; bytes != end; ++bytes) hash = (hash ^ *bytes) * 16777619u;
+    return hash;
+}
+
+bool VerdictStore::isIntact(const Record& record) {
+    return record.magic == recordMagic && record.checksum == checksumOf(record)
+        && record.challengeLength <= maxChallengeLength && record.signatureLength <= maxSignatureLength;
+}
+
+VerdictStore::Key VerdictStore::keyOf(const std::string& userId, const std::string& licenseKey,
+    const std::string& scope, const std::string& metadata) {
+    // Length-prefixed so that no two different keys produce the same digest input.
+    std::string input;
+    input.reserve(userId.size() + licenseKey.size() + scope.size() + metadata.size() + 4 * sizeof(uint32_t));
+    for (const std::string* part : { &userId, &licenseKey, &scope, &metadata }) {
+        uint32_t length = static_cast<uint32_t>(part->size());
+        input.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        input.append(*part);
+    }
+
+    Key key;
+    unsigned int digestLength = 0;
+    if (EVP_Digest(input.data(), input.size(), key.digest, &digestLength, EVP_sha256(), NULL) != 1 || digestLength != keyDigestLength)
+        std::memset(key.digest, 0, sizeof(key.digest));
+    std::memcpy(&key.hash, key.digest, sizeof(key.hash));
+    return key;
+}
+
+bool VerdictStore::matches(const Record& record, const Key& key) {
+    return record.keyHash == key.hash && std::memcmp(record.keyDigest, key.digest, keyDigestLength) == 0;
+}
+
+const VerdictStore::Record* VerdictStore::latestFor(const Key& key) const {
+    // A different key sharing the hash only ever costs a miss, never its verdict.
+    auto fresh = appended.find(key.hash);
+    if (fresh != appended.end()) return matches(fresh->second, key) ? &fresh->second : nullptr;
+
+    auto stored = mappedIndex.find(key.hash);
+    if (stored != mappedIndex.end() && matches(*stored->second, key)) return stored->second;
+    return nullptr;
+}
+
+bool VerdictStore::lookup(const Key& key, Record& record) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const Record* latest = latestFor(key);
+    if (!latest) return false;
+    record = *latest;
+    return true;
+}
+
+bool VerdictStore::append(const Key& key, int verdict, const std::string& challenge, const std::string& signedChallenge) {
+    if (!isOpen() || challenge.size() > maxChallengeLength || signedChallenge.size() > maxSignatureLength) return false;
+
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.magic = recordMagic;
+    record.keyHash = key.hash;
+    std::memcpy(record.keyDigest, key.digest, keyDigestLength);
+    record.timestamp = static_cast<int64_t>(std::time(nullptr));
+    record.verdict = verdict;
+    record.challengeLength = static_cast<uint16_t>(challenge.size());
+    record.signatureLength = static_cast<uint16_t>(signedChallenge.size());
+    std::memcpy(record.challenge, challenge.data(), challenge.size());
+    std::memcpy(record.signedChallenge, signedChallenge.data(), signedChallenge.size());
+    record.checksum = checksumOf(record);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const Record* latest = latestFor(key);
+    if (latest && latest->verdict == verdict && record.timestamp - latest->timestamp < options.rewriteInterval.count())
+        return true;
+
+    if (!writeRecord(record)) return false;
+    appended[key.hash] = record;
+    return true;
+}
+
+bool VerdictStore::compact() {
+    std::vector<Record> live;
+    live.reserve(mappedIndex.size());
+    for (const auto& entry : mappedIndex) live.push_back(*entry.second);
+
+    std::string temporaryPath = options.path + ".compact";
+    std::FILE* out = std::fopen(temporaryPath.c_str(), "wb");
+    if (!out) return false;
+    bool written = std::fwrite(live.data(), sizeof(Record), live.size(), out) == live.size() && std::fflush(out) == 0;
+#ifndef _WIN32
+    written = written && fsync(fileno(out)) == 0;
+#endif
+    std::fclose(out);
+    if (!written) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    unmapFile();
+    closeFile();
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temporaryPath.c_str(), options.path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool renamed = std::rename(temporaryPath.c_str(), options.path.c_str()) == 0;
+#endif
+    if (!renamed) std::remove(temporaryPath.c_str());
+    return openFile(options.path) && renamed;
+}
+
+#ifdef _WIN32
+
+bool VerdictStore::openFile(const std::string& path) {
+    // Drop a trailing partial record left behind by a crash before appending after it.
+    HANDLE writable = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (writable == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(writable, &size)) {
+        CloseHandle(writable);
+        return false;
+    }
+    LARGE_INTEGER aligned;
+    aligned.QuadPart = size.QuadPart - size.QuadPart % sizeof(Record);
+    if (aligned.QuadPart != size.QuadPart) {
+        SetFilePointerEx(writable, aligned, NULL, FILE_BEGIN);
+        SetEndOfFile(writable);
+    }
+
+    file = reinterpret_cast<FileHandle>(writable);
+    fileSize = static_cast<uint64_t>(aligned.QuadPart);
+    return mapFile(fileSize);
+}
+
+void VerdictStore::closeFile() {
+    if (file != invalidFile) CloseHandle(reinterpret_cast<HANDLE>(file));
+    file = invalidFile;
+}
+
+bool VerdictStore::mapFile(uint64_t size) {
+    mappedIndex.clear();
+    appended.clear();
+    if (size == 0) return true;
+
+    mapping = CreateFileMappingA(reinterpret_cast<HANDLE>(file), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(size));
+    if (!view) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+
+    mapped = static_cast<const Record*>(view);
+    mappedCount = static_cast<size_t>(size / sizeof(Record));
+    for (size_t i = 0; i < mappedCount; ++i) {
+        if (isIntact(mapped[i])) mappedIndex[mapped[i].keyHash] = &mapped[i];
+    }
+    return true;
+}
+
+void VerdictStore::unmapFile() {
+    if (mapped) UnmapViewOfFile(mapped);
+    if (mapping) CloseHandle(mapping);
+    mapped = nullptr;
+    mapping = nullptr;
+    mappedCount = 0;
+}
+
+bool VerdictStore::writeRecord(const Record& record) {
+    HANDLE handle = reinterpret_cast<HANDLE>(file);
+    OVERLAPPED at = {};
+    at.Offset = static_cast<DWORD>(fileSize);
+    at.OffsetHigh = static_cast<DWORD>(fileSize >> 32);
+    DWORD written = 0;
+    if (!WriteFile(handle, &record, sizeof(record), &written, &at) || written != sizeof(record)) {
+        // Cut off whatever part of the record did land so the file stays aligned.
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(fileSize);
+        if (SetFilePointerEx(handle, end, NULL, FILE_BEGIN)) SetEndOfFile(handle);
+        return false;
+    }
+    if (options.syncWrites && !FlushFileBuffers(handle)) return false;
+    fileSize += sizeof(record);
+    return true;
+}
+
+#else
+
+bool VerdictStore::openFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    // Drop a trailing partial record left behind by a crash before appending after it.
+    off_t aligned = info.st_size - info.st_size % static_cast<off_t>(sizeof(Record));
+    if (aligned != info.st_size && ftruncate(fd, aligned) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    file = static_cast<FileHandle>(fd);
+    fileSize = static_cast<uint64_t>(aligned);
+    return mapFile(fileSize);
+}
+
+void VerdictStore::closeFile() {
+    if (file != invalidFile) ::close(static_cast<int>(file));
+    file = invalidFile;
+}
+
+bool VerdictStore::mapFile(uint64_t size) {
+    mappedIndex.clear();
+    appended.clear();
+    if (size == 0) return true;
+
+    void* view = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, static_cast<int>(file), 0);
+    if (view == MAP_FAILED) return false;
+
+    mapped = static_cast<const Record*>(view);
+    mappedCount = static_cast<size_t>(size / sizeof(Record));
+    for (size_t i = 0; i < mappedCount; ++i) {
+        if (isIntact(mapped[i])) mappedIndex[mapped[i].keyHash] = &mapped[i];
+    }
+    return true;
+}
+
+void VerdictStore::unmapFile() {
+    if (mapped) munmap(const_cast<Record*>(mapped), mappedCount * sizeof(Record));
+    mapped = nullptr;
+    mappedCount = 0;
+}
+
+bool VerdictStore::writeRecord(const Record& record) {
+    int fd = static_cast<int>(file);
+    ssize_t written = pwrite(fd, &record, sizeof(record), static_cast<off_t>(fileSize));
+    if (written != static_cast<ssize_t>(sizeof(record))) {
+        // Cut off whatever part of the record did land so the file stays aligned. If that
+        // fails too, the next append still starts at fileSize and overwrites the torn bytes.
+        if (written > 0 && ftruncate(fd, static_cast<off_t>(fileSize)) != 0) return false;
+        return false;
+    }
+    if (options.syncWrites && fdatasync(fd) != 0) return false;
+    fileSize += sizeof(record);
+    return true;
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef LICENSE_GATE_VERDICT_STORE_H
+#define LICENSE_GATE_VERDICT_STORE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Append-only file of fixed-size verdict records. Existing records are memory-mapped and
+// read in place; new records are appended and kept in memory until the next open. Every
+// record carries a checksum, so a write torn by a crash is skipped when the file is loaded.
+// Compaction on open replaces the file, so one store file should belong to one process.
+class VerdictStore {
+public:
+    static constexpr size_t maxChallengeLength = 32;
+    static constexpr size_t maxSignatureLength = 928;
+    static constexpr size_t keyDigestLength = 32;
+
+    // Records are indexed by hash but only match on the SHA-256 of the full key, so a key
+    // crafted to collide with a stored one cannot borrow its verdict.
+    struct Key {
+        uint64_t hash;
+        unsigned char digest[keyDigestLength];
+    };
+    static Key keyOf(const std::string& userId, const std::string& licenseKey, const std::string& scope, const std::string& metadata);
+
+    struct Options {
+        std::string path;
+        // How old a stored verdict may be and still be used while the server is unreachable.
+        std::chrono::seconds maxOfflineAge = std::chrono::hours(24);
+        // Stored verdicts younger than this are used without asking the server (0 = never).
+        std::chrono::seconds freshFor = std::chrono::seconds(0);
+        // An unchanged verdict is rewritten only after this long.
+        std::chrono::seconds rewriteInterval = std::chrono::minutes(5);
+        bool syncWrites = true;
+    };
+
+#pragma pack(push, 1)
+    struct Record {
+        uint32_t magic;
+        uint32_t checksum;
+        uint64_t keyHash;
+        unsigned char keyDigest[keyDigestLength];
+        int64_t timestamp;
+        int32_t verdict;
+        uint16_t challengeLength;
+        uint16_t signatureLength;
+        char challenge[maxChallengeLength];
+        char signedChallenge[maxSignatureLength];
+    };
+#pragma pack(pop)
+
+    explicit VerdictStore(const Options& options);
+    ~VerdictStore();
+    VerdictStore(const VerdictStore&) = delete;
+    VerdictStore& operator=(const VerdictStore&) = delete;
+
+    bool isOpen() const { return file != invalidFile; }
+    const Options& getOptions() const { return options; }
+
+    bool lookup(const Key& key, Record& record);
+    bool append(const Key& key, int verdict, const std::string& challenge, const std::string& signedChallenge);
+
+private:
+    // A file descriptor, or a HANDLE on Windows.
+    using FileHandle = intptr_t;
+    static constexpr FileHandle invalidFile = -1;
+
+    static uint32_t checksumOf(const Record& record);
+    static bool isIntact(const Record& record);
+    static bool matches(const Record& record, const Key& key);
+    const Record* latestFor(const Key& key) const;
+
+    bool openFile(const std::string& path);
+    void closeFile();
+    bool mapFile(uint64_t size);
+    void unmapFile();
+    bool compact();
+    bool writeRecord(const Record& record);
+
+    Options options;
+    FileHandle file = invalidFile;
+    // End of the last whole record; appends are written here rather than at end of file.
+    uint64_t fileSize = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+    const Record* mapped = nullptr;
+    size_t mappedCount = 0;
+
+    std::mutex mutex;
+    std::unordered_map<uint64_t, const Record*> mappedIndex;
+    std::unordered_map<uint64_t, Record> appended;
+};
+
+#endif // LICENSE_GATE_VERDICT_STORE_H
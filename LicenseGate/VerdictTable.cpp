@@ -0,0 +1,214 @@
+#include "VerdictTable.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr uint32_t tableMagic = 0x54564c4c; // "LLVT"
+    constexpr uint32_t tableVersion = 1;
+}
+
+struct VerdictTable::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t slotCount;
+    std::atomic<uint32_t> retired;
+    char padding[44];
+};
+
+struct VerdictTable::Slot {
+    std::atomic<uint32_t> sequence;
+    uint32_t keyLength;
+    uint64_t hash;
+    int64_t expiresAt;
+    int32_t verdict;
+    char key[maxKeyLength];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+    "the table is shared between processes, so its atomics must be plain lock-free words");
+
+namespace {
+    // Marks a table left behind by an earlier writer, so that its readers look for the new one.
+    void retireExisting(const std::string& path, size_t headerSize) {
+        int fd = ::open(path.c_str(), O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_uid == geteuid() && static_cast<size_t>(info.st_size) >= headerSize) {
+            void* view = mmap(nullptr, headerSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (view != MAP_FAILED) {
+                uint32_t magic;
+                std::memcpy(&magic, view, sizeof(magic));
+                if (magic == tableMagic) reinterpret_cast<std::atomic<uint32_t>*>(static_cast<char*>(view) + 16)->store(1, std::memory_order_release);
+                munmap(view, headerSize);
+            }
+        }
+        ::close(fd);
+    }
+}
+
+std::unique_ptr<VerdictTable> VerdictTable::create(const std::string& path, size_t slotCount, uint32_t mode) {
+    static_assert(sizeof(Header) == 64 && sizeof(Slot) == 256, "the file layout is fixed");
+    static_assert(offsetof(Header, retired) == 16, "retireExisting writes the flag by offset");
+    if (slotCount == 0) return nullptr;
+
+    // A new file, renamed over the old one, so that readers of the old table never see it resized.
+    std::string temporaryPath = path + ".tmp";
+    ::unlink(temporaryPath.c_str());
+    // The table holds license keys, scopes and metadata in the clear; readers reject a table
+    // anyone but the owner can write to.
+    mode_t permissions = static_cast<mode_t>(mode) & 0644;
+    int fd = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) return nullptr;
+
+    size_t size = sizeof(Header) + slotCount * sizeof(Slot);
+    void* view = MAP_FAILED;
+    if (fchmod(fd, permissions) == 0 && ftruncate(fd, static_cast<off_t>(size)) == 0)
+        view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        ::unlink(temporaryPath.c_str());
+        return nullptr;
+    }
+
+    Header* header = new (view) Header();
+    header->magic = tableMagic;
+    header->version = tableVersion;
+    header->slotCount = slotCount;
+    Slot* slots = reinterpret_cast<Slot*>(header + 1);
+    for (size_t i = 0; i < slotCount; ++i) new (&slots[i]) Slot();
+
+    retireExisting(path, sizeof(Header));
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        munmap(view, size);
+        ::unlink(temporaryPath.c_str());
+        return nullptr;
+    }
+    return std::unique_ptr<VerdictTable>(new VerdictTable(view, size, true));
+}
+
+std::unique_ptr<VerdictTable> VerdictTable::open(const std::string& path, uint32_t owner) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    void* view = MAP_FAILED;
+    size_t size = 0;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_uid == owner && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0
+        && static_cast<size_t>(info.st_size) > sizeof(Header)) {
+        size = static_cast<size_t>(info.st_size);
+        view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (view == MAP_FAILED) return nullptr;
+
+    const Header* header = static_cast<const Header*>(view);
+    if (header->magic != tableMagic || header->version != tableVersion || header->slotCount == 0
+        || header->slotCount > (size - sizeof(Header)) / sizeof(Slot) || size != sizeof(Header) + header->slotCount * sizeof(Slot)) {
+        munmap(view, size);
+        return nullptr;
+    }
+    return std::unique_ptr<VerdictTable>(new VerdictTable(view, size, false));
+}
+
+VerdictTable::VerdictTable(void* view, size_t size, bool writable) : view(view), size(size), writable(writable),
+    header(static_cast<Header*>(view)), slots(reinterpret_cast<Slot*>(header + 1)), count(static_cast<size_t>(header->slotCount)) {
+}
+
+VerdictTable::~VerdictTable() {
+    if (writable) header->retired.store(1, std::memory_order_release);
+    munmap(view, size);
+}
+
+bool VerdictTable::retired() const {
+    return header->retired.load(std::memory_order_acquire) != 0;
+}
+
+bool VerdictTable::buildKey(std::string& key, const std::string& licenseKey, const std::string& scope, const std::string& metadata) {
+    key.clear();
+    if (licenseKey.size() + scope.size() + metadata.size() + 2 > maxKeyLength) return false;
+    key.append(licenseKey).push_back('\0');
+    key.append(scope).push_back('\0');
+    key.append(metadata);
+    return true;
+}
+
+// FNV-1a, so that the daemon and its clients agree whichever standard library built them.
+uint64_t VerdictTable::hashOf(const std::string& key) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) hash = (hash ^ c) * 1099511628211ull;
+    return hash;
+}
+
+bool VerdictTable::lookup(const std::string& licenseKey, const std::string& scope, const std::string& metadata, int& verdict) const {
+    thread_local std::string key;
+    if (!buildKey(key, licenseKey, scope, metadata)) return false;
+    uint64_t hash = hashOf(key);
+    int64_t now = ticks(Clock::now());
+
+    for (size_t probe = 0; probe < probeLimit; ++probe) {
+        const Slot& slot = slots[(hash + probe) % count];
+        for (int attempt = 0;; ++attempt) {
+            if (attempt == 4) return false; // the writer keeps changing this slot; ask the daemon
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+
+            uint32_t keyLength = slot.keyLength;
+            uint64_t slotHash = slot.hash;
+            int64_t expiresAt = slot.expiresAt;
+            int32_t slotVerdict = slot.verdict;
+            bool matches = slotHash == hash && keyLength == key.size() && std::memcmp(slot.key, key.data(), key.size()) == 0;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+
+            // Slots are only ever overwritten, so an empty one ends the probe sequence.
+            if (keyLength == 0) return false;
+            if (!matches) break;
+            if (expiresAt <= now) return false;
+            verdict = slotVerdict;
+            return true;
+        }
+    }
+    return false;
+}
+
+void VerdictTable::store(const std::string& licenseKey, const std::string& scope, const std::string& metadata, int verdict, Clock::time_point expiresAt) {
+    if (!writable) return;
+    thread_local std::string key;
+    if (!buildKey(key, licenseKey, scope, metadata)) return;
+    uint64_t hash = hashOf(key);
+    int64_t now = ticks(Clock::now());
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    // The slot already holding the key, else the first empty or expired one, else the one
+    // expiring soonest.
+    Slot* target = nullptr;
+    for (size_t probe = 0; probe < probeLimit; ++probe) {
+        Slot& slot = slots[(hash + probe) % count];
+        if (slot.keyLength == key.size() && slot.hash == hash && std::memcmp(slot.key, key.data(), key.size()) == 0) {
+            target = &slot;
+            break;
+        }
+        if (slot.keyLength == 0) {
+            target = &slot;
+            break;
+        }
+        if (!target || (target->expiresAt > now && slot.expiresAt < target->expiresAt)) target = &slot;
+    }
+
+    uint32_t sequence = target->sequence.load(std::memory_order_relaxed);
+    target->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    target->keyLength = static_cast<uint32_t>(key.size());
+    target->hash = hash;
+    target->expiresAt = ticks(expiresAt);
+    target->verdict = verdict;
+    std::memcpy(target->key, key.data(), key.size());
+    target->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,63 @@
+#ifndef LICENSE_GATE_VERDICT_TABLE_H
+#define LICENSE_GATE_VERDICT_TABLE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Verdicts published by the sidecar daemon in a memory-mapped file, so that every process on
+// the host can answer a repeated lookup without a round trip over the socket. Only the daemon
+// writes; clients map the file read-only. Each slot is guarded by a sequence number that is
+// odd while the slot is being written, so a reader copies the slot and retries if the number
+// changed, without taking a lock. Keys are placed by open addressing over a few slots; keys
+// longer than maxKeyLength are never published. Expiry uses the steady clock, which is the
+// same for every process on the host. POSIX only.
+class VerdictTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t maxKeyLength = 228;
+
+    // Replaces the file at path with an empty table with the given permissions, less any
+    // execute bits and write access for anyone but the owner. Null if it cannot be created.
+    static std::unique_ptr<VerdictTable> create(const std::string& path, size_t slotCount, uint32_t mode);
+    // Maps the table read-only. Null unless the file is a table owned by owner that nobody
+    // else can write to.
+    static std::unique_ptr<VerdictTable> open(const std::string& path, uint32_t owner);
+
+    ~VerdictTable();
+    VerdictTable(const VerdictTable&) = delete;
+    VerdictTable& operator=(const VerdictTable&) = delete;
+
+    size_t slotCount() const { return count; }
+    // Set once the writer has been destroyed or another table has been created over it.
+    bool retired() const;
+
+    bool lookup(const std::string& licenseKey, const std::string& scope, const std::string& metadata, int& verdict) const;
+    void store(const std::string& licenseKey, const std::string& scope, const std::string& metadata, int verdict, Clock::time_point expiresAt);
+
+private:
+    struct Header;
+    struct Slot;
+
+    static constexpr size_t probeLimit = 8;
+
+    VerdictTable(void* view, size_t size, bool writable);
+
+    static bool buildKey(std::string& key, const std::string& licenseKey, const std::string& scope, const std::string& metadata);
+    static uint64_t hashOf(const std::string& key);
+    static int64_t ticks(Clock::time_point time) { return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(); }
+
+    void* view;
+    size_t size;
+    bool writable;
+    Header* header;
+    Slot* slots;
+    size_t count;
+    std::mutex writeMutex;
+};
+
+#endif // LICENSE_GATE_VERDICT_TABLE_H
@@ -0,0 +1,92 @@
+#include "Allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <curl/curl.h>
+#include <openssl/crypto.h>
+
+namespace {
+    std::atomic<uint64_t> cppAllocations{ 0 };
+    std::atomic<uint64_t> curlAllocations{ 0 };
+    std::atomic<uint64_t> opensslAllocations{ 0 };
+
+    void* allocate(std::size_t size) {
+        cppAllocations.fetch_add(1, std::memory_order_relaxed);
+        if (void* block = std::malloc(size ? size : 1)) return block;
+        throw std::bad_alloc();
+    }
+
+    void* curlMalloc(size_t size) {
+        curlAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size);
+    }
+
+    void* curlRealloc(void* block, size_t size) {
+        curlAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::realloc(block, size);
+    }
+
+    void* curlCalloc(size_t count, size_t size) {
+        curlAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::calloc(count, size);
+    }
+
+    char* curlStrdup(const char* text) {
+        size_t size = std::strlen(text) + 1;
+        char* copy = static_cast<char*>(curlMalloc(size));
+        if (copy) std::memcpy(copy, text, size);
+        return copy;
+    }
+
+    void* opensslMalloc(size_t size, const char*, int) {
+        opensslAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size);
+    }
+
+    void* opensslRealloc(void* block, size_t size, const char*, int) {
+        opensslAllocations.fetch_add(1, std::memory_order_relaxed);
+        return std::realloc(block, size);
+    }
+
+    void opensslFree(void* block, const char*, int) {
+        std::free(block);
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    cppAllocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    cppAllocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept { std::free(block); }
+
+bool Allocations::install() {
+    bool hooked = CRYPTO_set_mem_functions(opensslMalloc, opensslRealloc, opensslFree) == 1;
+    return curl_global_init_mem(CURL_GLOBAL_DEFAULT, curlMalloc, std::free, curlRealloc, curlStrdup, curlCalloc) == CURLE_OK && hooked;
+}
+
+Allocations::Counts Allocations::snapshot() {
+    Counts counts;
+    counts.cpp = cppAllocations.load(std::memory_order_relaxed);
+    counts.curl = curlAllocations.load(std::memory_order_relaxed);
+    counts.openssl = opensslAllocations.load(std::memory_order_relaxed);
+    return counts;
+}
+
+Allocations::Counts Allocations::since(const Counts& start) {
+    Counts now = snapshot();
+    now.cpp -= start.cpp;
+    now.curl -= start.curl;
+    now.openssl -= start.openssl;
+    return now;
+}
@@ -0,0 +1,24 @@
+#ifndef LICENSE_GATE_BENCH_ALLOCATIONS_H
+#define LICENSE_GATE_BENCH_ALLOCATIONS_H
+
+#include <cstdint>
+
+// Counts heap allocations made by C++ code (operator new), by libcurl and by OpenSSL. libcurl
+// and OpenSSL are counted through their allocator hooks, which install() sets; it must run
+// before either library allocates anything, so call it first thing in main. Allocations that
+// libraries such as nghttp2 or the C library make with malloc directly are not counted.
+namespace Allocations {
+    struct Counts {
+        uint64_t cpp = 0;
+        uint64_t curl = 0;
+        uint64_t openssl = 0;
+
+        uint64_t total() const { return cpp + curl + openssl; }
+    };
+
+    bool install();
+    Counts snapshot();
+    Counts since(const Counts& start);
+}
+
+#endif // LICENSE_GATE_BENCH_ALLOCATIONS_H
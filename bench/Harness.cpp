@@ -0,0 +1,128 @@
+#include "Harness.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+#include <openssl/crypto.h>
+
+bool Harness::parseArguments(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--filter=", 0) == 0) options.filter = argument.substr(9);
+        else if (argument.rfind("--min-time-ms=", 0) == 0) options.minTime = std::chrono::milliseconds(std::atol(argument.c_str() + 14));
+        else if (argument.rfind("--samples=", 0) == 0) options.samples = std::max(1, std::atoi(argument.c_str() + 10));
+        else {
+            std::cerr << "usage: " << argv[0] << " [--filter=SUBSTRING] [--min-time-ms=N] [--samples=N]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+Harness::Harness(const Options& options) : options(options) {
+    nlohmann::json context = {
+        { "suite", "licensegate_bench" },
+        { "curl", curl_version() },
+        { "openssl", OpenSSL_version(OPENSSL_VERSION) },
+        { "samples", options.samples },
+        { "min_time_ms", options.minTime.count() },
+    };
+    std::cout << nlohmann::json({ { "context", context } }).dump() << std::endl;
+}
+
+bool Harness::selected(const std::string& stage) const {
+    return options.filter.empty() || stage.find(options.filter) != std::string::npos;
+}
+
+void Harness::report(const std::string& stage, uint64_t iterations, std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    nlohmann::json line = {
+        { "stage", stage },
+        { "iterations", iterations },
+        { "ns_per_op", samples[samples.size() / 2] },
+        { "ns_per_op_min", samples.front() },
+        { "ns_per_op_max", samples.back() },
+    };
+    std::cout << line.dump() << std::endl;
+}
+
+void Harness::reportThroughput(const std::string& stage, int threads, uint64_t operations, double seconds) {
+    nlohmann::json line = {
+        { "stage", stage },
+        { "threads", threads },
+        { "operations", operations },
+        { "ops_per_second", seconds > 0 ? operations / seconds : 0.0 },
+    };
+    std::cout << line.dump() << std::endl;
+}
+
+void Harness::reportLatencies(const std::string& stage, std::vector<double> nanoseconds) {
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    auto percentile = [&](double q) { return nanoseconds[std::min(nanoseconds.size() - 1, static_cast<size_t>(q * nanoseconds.size()))]; };
+    nlohmann::json line = {
+        { "stage", stage },
+        { "operations", nanoseconds.size() },
+        { "ns_p50", percentile(0.5) },
+        { "ns_p90", percentile(0.9) },
+        { "ns_p99", percentile(0.99) },
+        { "ns_p999", percentile(0.999) },
+        { "ns_max", nanoseconds.back() },
+    };
+    std::cout << line.dump() << std::endl;
+}
+
+void Harness::reportCounts(const std::string& stage, double seconds, const std::vector<std::pair<std::string, uint64_t>>& counts) {
+    nlohmann::json line = {
+        { "stage", stage },
+        { "seconds", seconds },
+    };
+    for (const auto& count : counts) {
+        line[count.first] = count.second;
+        line[count.first + "_per_second"] = seconds > 0 ? count.second / seconds : 0.0;
+    }
+    std::cout << line.dump() << std::endl;
+}
+
+void Harness::reportProcesses(const std::string& stage, int processes, double seconds, const std::vector<std::pair<std::string, uint64_t>>& counts,
+    double residentGrowthKbPerProcess) {
+    nlohmann::json line = {
+        { "stage", stage },
+        { "processes", processes },
+        { "seconds", seconds },
+        { "resident_growth_kb_per_process", residentGrowthKbPerProcess },
+    };
+    for (const auto& count : counts) {
+        line[count.first] = count.second;
+        line[count.first + "_per_second"] = seconds > 0 ? count.second / seconds : 0.0;
+    }
+    std::cout << line.dump() << std::endl;
+}
+
+void Harness::reportAllocations(const std::string& stage, uint64_t calls, const Allocations::Counts& counts, const Allocations::Counts& budget) {
+    auto perCall = [calls](uint64_t count) { return static_cast<double>(count) / calls; };
+    bool passed = perCall(counts.cpp) <= budget.cpp && perCall(counts.curl) <= budget.curl && perCall(counts.openssl) <= budget.openssl;
+    nlohmann::json line = {
+        { "stage", stage },
+        { "calls", calls },
+        { "cpp_per_call", perCall(counts.cpp) },
+        { "curl_per_call", perCall(counts.curl) },
+        { "openssl_per_call", perCall(counts.openssl) },
+        { "allocations_per_call", perCall(counts.total()) },
+        { "budget_per_call", { { "cpp", budget.cpp }, { "curl", budget.curl }, { "openssl", budget.openssl } } },
+        { "passed", passed },
+    };
+    std::cout << line.dump() << std::endl;
+    if (!passed) throw std::runtime_error(stage + ": allocations per call over budget");
+}
+
+void Harness::reportCheck(const std::string& check, uint64_t cases) {
+    nlohmann::json line = {
+        { "check", check },
+        { "cases", cases },
+        { "passed", true },
+    };
+    std::cout << line.dump() << std::endl;
+}
@@ -0,0 +1,94 @@
+#ifndef LICENSE_GATE_BENCH_HARNESS_H
+#define LICENSE_GATE_BENCH_HARNESS_H
+
+#include "Allocations.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Keeps the compiler from discarding a value computed inside a timed loop.
+template<typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+// Times one stage at a time and writes one JSON object per line to stdout, so two runs can
+// be compared with diff or loaded line by line. The first line describes the build.
+class Harness {
+public:
+    struct Options {
+        std::string filter;
+        std::chrono::milliseconds minTime = std::chrono::milliseconds(200);
+        int samples = 5;
+    };
+
+    static bool parseArguments(int argc, char** argv, Options& options);
+
+    explicit Harness(const Options& options);
+
+    bool selected(const std::string& stage) const;
+    std::chrono::milliseconds minTime() const { return options.minTime; }
+
+    // For stages that measure work spread over several threads rather than one operation.
+    void reportThroughput(const std::string& stage, int threads, uint64_t operations, double seconds);
+
+    // For stages where the spread matters more than the typical time, e.g. network tails.
+    void reportLatencies(const std::string& stage, std::vector<double> nanoseconds);
+
+    // For simulations that count outcomes over a run; each count is also reported per second.
+    void reportCounts(const std::string& stage, double seconds, const std::vector<std::pair<std::string, uint64_t>>& counts);
+
+    // For work spread over several processes on one host; counts are totals over all of them.
+    void reportProcesses(const std::string& stage, int processes, double seconds, const std::vector<std::pair<std::string, uint64_t>>& counts,
+        double residentGrowthKbPerProcess);
+
+    // For heap allocations per call. The budget is per call for each source; throws if any
+    // source is over it.
+    void reportAllocations(const std::string& stage, uint64_t calls, const Allocations::Counts& counts, const Allocations::Counts& budget);
+
+    // For differential checks that run before the stages they guard.
+    void reportCheck(const std::string& check, uint64_t cases);
+
+    template<typename Body>
+    void run(const std::string& stage, Body&& body) {
+        if (!selected(stage)) return;
+
+        body(); // warm caches and lazily initialised state
+
+        // Grow the batch until it fills one sample's share of the time budget.
+        const double target = std::chrono::duration<double, std::nano>(options.minTime).count() / options.samples;
+        uint64_t iterations = 1;
+        for (;;) {
+            double elapsed = time(body, iterations);
+            if (elapsed >= target || iterations >= (uint64_t(1) << 32)) break;
+            uint64_t estimate = elapsed > 0 ? uint64_t(iterations * target / elapsed * 1.1) : iterations * 10;
+            iterations = estimate > iterations * 10 ? iterations * 10 : (estimate > iterations ? estimate : iterations * 2);
+        }
+
+        std::vector<double> samples;
+        for (int i = 0; i < options.samples; ++i) samples.push_back(time(body, iterations) / iterations);
+        report(stage, iterations, samples);
+    }
+
+private:
+    template<typename Body>
+    static double time(Body& body, uint64_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) body();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const std::string& stage, uint64_t iterations, std::vector<double> samples);
+
+    Options options;
+};
+
+#endif // LICENSE_GATE_BENCH_HARNESS_H
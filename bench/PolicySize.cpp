@@ -0,0 +1,27 @@
+#include <LicenseGateImpl.hpp>
+#include <fstream>
+#include <sstream>
+
+// Built twice: with the runtime-configured LicenseGate, and with challenges always on and
+// debug output and the verdict cache compiled out. Both instantiate every member, so the
+// difference in size is what the policies remove.
+#ifdef LICENSEGATE_SIZE_FIXED
+template class BasicLicenseGate<LicenseGatePolicy::Enabled, LicenseGatePolicy::Disabled, LicenseGatePolicy::Disabled>;
+using Client = BasicLicenseGate<LicenseGatePolicy::Enabled, LicenseGatePolicy::Disabled, LicenseGatePolicy::Disabled>;
+#else
+using Client = LicenseGate;
+#endif
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " USER_ID PUBLIC_KEY_FILE LICENSE_KEY [SERVER]" << std::endl;
+        return 2;
+    }
+    std::ifstream in(argv[2]);
+    std::stringstream publicKey;
+    publicKey << in.rdbuf();
+
+    Client gate(argv[1], publicKey.str());
+    if (argc > 4) gate.setValidationServer(argv[4]);
+    return gate.verify(argv[3]) == LicenseGateBase::ValidationType::VALID ? 0 : 1;
+}
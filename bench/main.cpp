@@ -0,0 +1,1243 @@
+#include "Allocations.hpp"
+#include "Harness.hpp"
+
+#include <LicenseGateImpl.hpp>
+#include <XorStr.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include <openssl/bio.h>
+
+#ifndef _WIN32
+#include <SidecarClient.hpp>
+#include <SidecarServer.hpp>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct SigningKey {
+    std::shared_ptr<EVP_PKEY> key;
+    std::string publicPem;
+
+    // Signs the way the license server does: RSA PKCS#1 v1.5 over SHA-256, base64 encoded.
+    std::string sign(const std::string& message) const {
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+        size_t signatureLength = 0;
+        if (!ctx || EVP_DigestSignInit(ctx.get(), NULL, EVP_sha256(), NULL, key.get()) <= 0
+            || EVP_DigestSign(ctx.get(), NULL, &signatureLength, (const unsigned char*)message.data(), message.size()) <= 0)
+            throw std::runtime_error("Failed to sign challenge");
+
+        std::vector<unsigned char> signature(signatureLength);
+        if (EVP_DigestSign(ctx.get(), signature.data(), &signatureLength, (const unsigned char*)message.data(), message.size()) <= 0)
+            throw std::runtime_error("Failed to sign challenge");
+
+        std::string encoded(4 * ((signatureLength + 2) / 3), '\0');
+        EVP_EncodeBlock((unsigned char*)&encoded[0], signature.data(), (int)signatureLength);
+        return encoded;
+    }
+};
+
+SigningKey generateKey(int bits) {
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL), EVP_PKEY_CTX_free);
+    EVP_PKEY* key = NULL;
+    if (!ctx || EVP_PKEY_keygen_init(ctx.get()) <= 0 || EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), bits) <= 0
+        || EVP_PKEY_keygen(ctx.get(), &key) <= 0)
+        throw std::runtime_error("Failed to generate RSA key");
+
+    SigningKey result;
+    result.key.reset(key, EVP_PKEY_free);
+
+    std::unique_ptr<BIO, decltype(&BIO_free)> bio(BIO_new(BIO_s_mem()), BIO_free);
+    PEM_write_bio_PUBKEY(bio.get(), key);
+    char* pem = NULL;
+    long pemLength = BIO_get_mem_data(bio.get(), &pem);
+    result.publicPem.assign(pem, pemLength);
+    return result;
+}
+
+// Keys are generated on first use so that a filtered run only pays for the keys it needs.
+const SigningKey& signingKey(int bits, int index = 0) {
+    static std::map<std::pair<int, int>, SigningKey> keys;
+    auto found = keys.find({ bits, index });
+    if (found == keys.end()) found = keys.emplace(std::make_pair(bits, index), generateKey(bits)).first;
+    return found->second;
+}
+
+const std::string userId = "a1d77";
+const std::string licenseKey = "d395fd0d-73bb-4dfd-b480-ad6cff1dc69d";
+const std::string challenge = "1760000000";
+
+std::string curlEscape(CURL* curl, const std::string& text) {
+    char* escaped = curl_easy_escape(curl, text.c_str(), (int)text.size());
+    std::string result(escaped);
+    curl_free(escaped);
+    return result;
+}
+
+// The decoder LicenseGate used before it had its own: a base64 BIO over a memory BIO.
+std::vector<unsigned char> bioDecode(const std::string& encoded) {
+    std::vector<unsigned char> decoded((encoded.size() * 3) / 4);
+    BIO* bio = BIO_push(BIO_new(BIO_f_base64()), BIO_new_mem_buf(encoded.data(), -1));
+    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+    int decodedLength = BIO_read(bio, decoded.data(), (int)encoded.size());
+    decoded.resize(decodedLength > 0 ? decodedLength : 0);
+    BIO_free_all(bio);
+    return decoded;
+}
+
+std::string encodeBase64(const std::vector<unsigned char>& bytes) {
+    std::string encoded(4 * ((bytes.size() + 2) / 3), '\0');
+    EVP_EncodeBlock((unsigned char*)&encoded[0], bytes.data(), (int)bytes.size());
+    return encoded;
+}
+
+bool isStrictBase64(const std::string& text) {
+    static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    if (text.size() % 4 != 0) return false;
+    size_t padding = 0;
+    if (!text.empty() && text.back() == '=') padding = text[text.size() - 2] == '=' ? 2 : 1;
+    for (size_t i = 0; i < text.size() - padding; ++i)
+        if (alphabet.find(text[i]) == std::string::npos) return false;
+    return true;
+}
+
+// One counter from licensegate_mock_server's GET /stats.
+uint64_t mockCounter(const std::string& server, const std::string& name) {
+    std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl(curl_easy_init(), curl_easy_cleanup);
+    std::string body;
+    std::string url = server + "/stats";
+    curl_easy_setopt(curl.get(), CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, +[](char* data, size_t size, size_t count, void* out) {
+        static_cast<std::string*>(out)->append(data, size * count);
+        return size * count;
+    });
+    curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, &body);
+    long status = 0;
+    if (curl_easy_perform(curl.get()) != CURLE_OK || curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &status) != CURLE_OK || status != 200)
+        throw std::runtime_error(url + " did not answer; LICENSEGATE_BENCH_MOCK_SERVER must be licensegate_mock_server");
+    nlohmann::json stats = nlohmann::json::parse(body, nullptr, false);
+    if (!stats.is_object() || !stats.contains(name)) throw std::runtime_error(url + " has no " + name + " counter");
+    return stats[name].get<uint64_t>();
+}
+
+// Random bytes, biased towards unreserved characters so that long runs reach the SIMD path.
+std::string randomText(std::mt19937& rng) {
+    static const char unreserved[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~";
+    std::string text(rng() % 200, '\0');
+    bool mostlyUnreserved = rng() % 2 == 0;
+    for (char& c : text) {
+        if (mostlyUnreserved && rng() % 16 != 0) c = unreserved[rng() % (sizeof(unreserved) - 1)];
+        else c = static_cast<char>(rng() % 256);
+    }
+    return text;
+}
+
+}
+
+// Befriended by LicenseGate so the private pipeline stages can be timed one by one.
+struct LicenseGateBenchmark {
+    static void run(Harness& harness) {
+        buildUrl(harness);
+        urlEncode(harness);
+        base64Decode(harness);
+        verifyChallenge(harness);
+        keyRingRotation(harness);
+        parseResponse(harness);
+        getValidationType(harness);
+        xorstrDecrypts(harness);
+        metrics(harness);
+        debugLogging(harness);
+        policies(harness);
+        watchedVerdict(harness);
+        allocations(harness);
+        verifyLatency(harness);
+        verifyTail(harness);
+        hedgeBreaker(harness);
+        coldStart(harness);
+        rateLimit(harness);
+        coalescing(harness);
+        deadlines(harness);
+#ifndef _WIN32
+        sidecar(harness);
+#endif
+        verifyScaling(harness);
+        verifyBatch(harness);
+    }
+
+    static void buildUrl(Harness& harness) {
+        LicenseGate plain(userId);
+        harness.run("buildUrl/plain", [&]() {
+            keep(plain.buildUrl(plain.currentConfig(), 0, licenseKey, "", "", ""));
+        });
+
+        LicenseGate full(userId);
+        full.enableChallenges();
+        harness.run("buildUrl/scope_metadata_challenge", [&]() {
+            keep(full.buildUrl(full.currentConfig(), 0, licenseKey, "pro features", "host=build-01&os=linux/x86_64", challenge));
+        });
+    }
+
+    // buildUrl must produce exactly what it produced when it escaped with curl_easy_escape.
+    static void urlEncode(Harness& harness) {
+        if (!harness.selected("urlEncode/")) return;
+
+        CURL* curl = curl_easy_init();
+        LicenseGate gate(userId);
+        gate.enableChallenges();
+        std::mt19937 rng(20240601);
+        const uint64_t cases = 100000;
+        for (uint64_t i = 0; i < cases; ++i) {
+            std::string scope = randomText(rng);
+            std::string metadata = randomText(rng);
+
+            std::string encoded;
+            UrlEncoder::append(encoded, scope);
+            if (encoded != curlEscape(curl, scope)) throw std::runtime_error("urlEncode: mismatch with curl_easy_escape");
+
+            std::string query;
+            if (!metadata.empty()) query += "?metadata=" + curlEscape(curl, metadata);
+            if (!scope.empty()) query += (query.empty() ? "?" : "&") + std::string("scope=") + curlEscape(curl, scope);
+            query += (query.empty() ? "?" : "&") + std::string("challenge=") + curlEscape(curl, challenge);
+            std::string expected = std::string("https://api.licensegate.io/license/") + userId + "/" + licenseKey + "/verify" + query;
+            if (gate.buildUrl(gate.currentConfig(), 0, licenseKey, scope, metadata, challenge) != expected)
+                throw std::runtime_error("urlEncode: buildUrl differs from the curl_easy_escape reference");
+        }
+        harness.reportCheck("urlEncode/matches_curl_easy_escape", cases);
+
+        const std::string unreserved = "host-01.build_farm~linux.x86_64.release.2024-06-01.abcdefghijklmn";
+        const std::string mixed = "host=build-01&os=linux/x86_64; user=J\xc3\xb6rg; path=C:\\Program Files\\App";
+        std::string out;
+        for (const auto& input : { std::make_pair("unreserved", &unreserved), std::make_pair("mixed", &mixed) }) {
+            harness.run(std::string("urlEncode/encoder_") + input.first, [&]() {
+                out.clear();
+                UrlEncoder::append(out, *input.second);
+                keep(out);
+            });
+            harness.run(std::string("urlEncode/curl_easy_escape_") + input.first, [&]() {
+                char* escaped = curl_easy_escape(curl, input.second->c_str(), (int)input.second->size());
+                keep(escaped);
+                curl_free(escaped);
+            });
+        }
+        curl_easy_cleanup(curl);
+    }
+
+    // Encodings of random bytes must round-trip and agree with the BIO path; mutated ones must
+    // be accepted exactly when they are strict base64, with the same bytes EVP_DecodeBlock gives.
+    static void base64Check(Harness& harness) {
+        std::mt19937 rng(20240602);
+        std::vector<unsigned char> decoded(1024), reference(1024);
+        const uint64_t cases = 100000;
+        for (uint64_t i = 0; i < cases; ++i) {
+            std::vector<unsigned char> bytes(rng() % 700);
+            for (unsigned char& byte : bytes) byte = static_cast<unsigned char>(rng());
+            std::string encoded = encodeBase64(bytes);
+
+            size_t length = 0;
+            if (!Base64::decode(encoded, decoded.data(), length) || std::vector<unsigned char>(decoded.begin(), decoded.begin() + length) != bytes
+                || bioDecode(encoded) != bytes)
+                throw std::runtime_error("base64_decode: round trip failed");
+
+            switch (rng() % 4) {
+            case 0: if (!encoded.empty()) encoded[rng() % encoded.size()] = static_cast<char>(rng()); break;
+            case 1: if (!encoded.empty()) encoded.erase(rng() % encoded.size(), 1); break;
+            case 2: encoded.insert(encoded.begin() + rng() % (encoded.size() + 1), static_cast<char>(rng())); break;
+            case 3: if (!encoded.empty()) encoded[rng() % encoded.size()] = "+/=A"[rng() % 4]; break;
+            }
+
+            size_t scalarLength = 0;
+            bool accepted = Base64::decode(encoded, decoded.data(), length);
+            if (accepted != Base64::decodeScalar(encoded, reference.data(), scalarLength) || accepted != isStrictBase64(encoded)
+                || (accepted && (length != scalarLength || !std::equal(decoded.begin(), decoded.begin() + length, reference.begin()))))
+                throw std::runtime_error("base64_decode: vectorized and scalar paths disagree");
+            if (!accepted) continue;
+
+            int openSslLength = EVP_DecodeBlock(reference.data(), (const unsigned char*)encoded.data(), (int)encoded.size());
+            size_t padding = std::count(encoded.end() - std::min<size_t>(encoded.size(), 2), encoded.end(), '=');
+            if (openSslLength < 0 || (size_t)openSslLength - padding != length || !std::equal(decoded.begin(), decoded.begin() + length, reference.begin()))
+                throw std::runtime_error("base64_decode: mismatch with EVP_DecodeBlock");
+        }
+        harness.reportCheck(Base64::vectorized() ? "base64_decode/matches_openssl_ssse3" : "base64_decode/matches_openssl", cases);
+    }
+
+    static void base64Decode(Harness& harness) {
+        if (harness.selected("base64_decode/matches_openssl")) base64Check(harness);
+
+        std::vector<unsigned char> decoded(1024);
+        for (int bits : { 2048, 4096 }) {
+            std::string suffix = "rsa" + std::to_string(bits);
+            if (!harness.selected("base64_decode/bio_" + suffix) && !harness.selected("base64_decode/scalar_" + suffix)
+                && !harness.selected("base64_decode/" + suffix)) continue;
+
+            std::string signature = signingKey(bits).sign(challenge);
+            harness.run("base64_decode/bio_" + suffix, [&]() {
+                keep(bioDecode(signature));
+            });
+            harness.run("base64_decode/scalar_" + suffix, [&]() {
+                size_t length = 0;
+                keep(Base64::decodeScalar(signature, decoded.data(), length));
+                keep(length);
+            });
+            harness.run("base64_decode/" + suffix, [&]() {
+                size_t length = 0;
+                keep(Base64::decode(signature, decoded.data(), length));
+                keep(length);
+            });
+        }
+    }
+
+    static void verifyChallenge(Harness& harness) {
+        for (int bits : { 2048, 4096 }) {
+            std::string stage = "verifyChallenge/rsa" + std::to_string(bits);
+            if (!harness.selected(stage)) continue;
+
+            const SigningKey& key = signingKey(bits);
+            LicenseGate gate(userId, key.publicPem);
+            std::string signature = key.sign(challenge);
+            if (!gate.verifyChallenge(gate.currentConfig(), challenge, signature)) throw std::runtime_error(stage + ": signature did not verify");
+
+            harness.run(stage, [&]() {
+                keep(gate.verifyChallenge(gate.currentConfig(), challenge, signature));
+            });
+        }
+    }
+
+    // A signature by a key from another rotation group must not pass for the active key, while
+    // one by another key of its own group must.
+    static void keyRingGroups(Harness& harness) {
+        std::string check = "keyRing/rejects_other_groups";
+        if (!harness.selected(check)) return;
+
+        LicenseGate gate(userId);
+        gate.enableChallenges();
+        gate.addPublicRsaKey("tenant-a", signingKey(2048, 1).publicPem);
+        gate.addPublicRsaKey("tenant-b", signingKey(2048, 2).publicPem);
+        gate.addPublicRsaKey("tenant-a-next", signingKey(2048, 3).publicPem, "tenant-a");
+        gate.setActiveKeyId("tenant-a");
+        if (gate.verifyChallenge(gate.currentConfig(), challenge, signingKey(2048, 2).sign(challenge)))
+            throw std::runtime_error(check + ": a signature by tenant-b passed for tenant-a");
+        if (!gate.verifyChallenge(gate.currentConfig(), challenge, signingKey(2048, 3).sign(challenge)))
+            throw std::runtime_error(check + ": a signature by the next key of tenant-a did not verify");
+        if (!gate.verifyChallenge(gate.currentConfig(), challenge, signingKey(2048, 1).sign(challenge)))
+            throw std::runtime_error(check + ": a signature by tenant-a did not verify");
+        gate.setActiveKeyId("tenant-b");
+        if (gate.verifyChallenge(gate.currentConfig(), challenge, signingKey(2048, 1).sign(challenge)))
+            throw std::runtime_error(check + ": a signature by tenant-a passed for tenant-b");
+        harness.reportCheck(check, 4);
+    }
+
+    // The signing key is added last and the active key id names the first key of the same
+    // rotation group, so every verify walks the whole ring, as it does right after a
+    // server-side key rotation.
+    static void keyRingRotation(Harness& harness) {
+        keyRingGroups(harness);
+        for (int keyCount : { 1, 2, 4, 8 }) {
+            std::string stage = "keyRing/rotation_keys" + std::to_string(keyCount);
+            if (!harness.selected(stage)) continue;
+
+            LicenseGate gate(userId);
+            gate.enableChallenges();
+            for (int i = 1; i < keyCount; ++i) gate.addPublicRsaKey("old" + std::to_string(i), signingKey(2048, i).publicPem, "rotation");
+            gate.addPublicRsaKey("current", signingKey(2048).publicPem, "rotation");
+            gate.setActiveKeyId(keyCount > 1 ? "old1" : "current");
+
+            std::string signature = signingKey(2048).sign(challenge);
+            if (!gate.verifyChallenge(gate.currentConfig(), challenge, signature)) throw std::runtime_error(stage + ": signature did not verify");
+
+            harness.run(stage, [&]() {
+                keep(gate.verifyChallenge(gate.currentConfig(), challenge, signature));
+            });
+        }
+    }
+
+    // Both variants read the same members the verify path needs, so the difference is the
+    // cost of building the DOM.
+    static void parseResponse(Harness& harness) {
+        std::vector<std::pair<std::string, std::string>> bodies = {
+            { "unsigned", "{\"valid\":true,\"result\":\"VALID\"}" },
+            { "not_active", "{\"valid\":false,\"result\":\"NOT_ACTIVE\"}" },
+        };
+        if (harness.selected("parse/json_dom/signed_rsa4096") || harness.selected("parse/streaming/signed_rsa4096")) {
+            bodies.push_back({ "signed_rsa4096",
+                "{\"valid\":true,\"result\":\"VALID\",\"signedChallenge\":\"" + signingKey(4096).sign(challenge) + "\"}" });
+        }
+
+        for (const auto& body : bodies) {
+            harness.run("parse/json_dom/" + body.first, [&]() {
+                json response = json::parse(body.second);
+                bool failed = response.contains("error") || !response.contains("result");
+                bool valid = response.contains("valid") && response["valid"].get<bool>();
+                std::string result = response["result"].get<std::string>();
+                std::string signedChallenge = response.contains("signedChallenge") ? response["signedChallenge"].get<std::string>() : "";
+                keep(failed);
+                keep(valid);
+                keep(result);
+                keep(signedChallenge);
+            });
+
+            LicenseGate::Response response;
+            harness.run("parse/streaming/" + body.first, [&]() {
+                response.parser.reset();
+                response.parser.feed(body.second.data(), body.second.size());
+                keep(response.parser.finish());
+                keep(response.parser.valid.type);
+                keep(response.parser.result.equals("VALID", 5));
+                keep(response.parser.signedChallenge.length);
+            });
+        }
+    }
+
+    static void getValidationType(Harness& harness) {
+        LicenseGate gate(userId);
+        for (const char* result : { "VALID", "NOT_ACTIVE", "RATE_LIMIT_EXCEEDED", "UNKNOWN_RESULT" }) {
+            std::string input = result;
+            harness.run(std::string("getValidationType/") + result, [&]() {
+                keep(gate.getValidationType(input));
+            });
+        }
+    }
+
+    // The literals each call decrypted on the stack before they moved to the StringTable.
+    static void xorstrDecrypts(Harness& harness) {
+        harness.run("xorstr/buildUrl_literals", []() {
+            keep(xorstr_("?metadata="));
+            keep(xorstr_("?"));
+            keep(xorstr_("&"));
+            keep(xorstr_("scope="));
+            keep(xorstr_("&"));
+            keep(xorstr_("challenge="));
+            keep(xorstr_("/license/"));
+            keep(xorstr_("/"));
+            keep(xorstr_("/verify"));
+        });
+        harness.run("xorstr/getValidationType_literals", []() {
+            keep(xorstr_("VALID"));
+            keep(xorstr_("NOT_FOUND"));
+            keep(xorstr_("NOT_ACTIVE"));
+        });
+
+        // The same literals read from the table that was decrypted once.
+        using Literal = StringTable::Literal;
+        harness.run("stringTable/buildUrl_literals", []() {
+            for (Literal literal : { Literal::QueryMetadata, Literal::QueryFirst, Literal::QueryNext, Literal::QueryScope, Literal::QueryNext,
+                Literal::QueryChallenge, Literal::LicensePath, Literal::PathSeparator, Literal::VerifyPath })
+                keep(StringTable::get(literal));
+        });
+        harness.run("stringTable/getValidationType_literals", []() {
+            for (Literal literal : { Literal::ResultValid, Literal::ResultNotFound, Literal::ResultNotActive })
+                keep(StringTable::get(literal));
+        });
+    }
+
+    // The bookkeeping added to every verify: one phase sample and one result count.
+    static void metrics(Harness& harness) {
+        LicenseGate gate(userId);
+        auto duration = std::chrono::microseconds(1500);
+        harness.run("metrics/record_phase_and_result", [&]() {
+            gate.metrics.record(Metrics::Phase::Verify, duration);
+            gate.metrics.countResult(0);
+        });
+    }
+
+    // Debug mode on the request path. The sink discards records, so the stages time the
+    // logging threads, not the output; a full ring drops records instead of waiting.
+    static void debugLogging(Harness& harness) {
+        Logger::Options options;
+        options.sink = [](const Logger::Record&) {};
+
+        LicenseGate quiet(userId, signingKey(2048).publicPem);
+        LicenseGate debug(userId, signingKey(2048).publicPem);
+        debug.enableDebug(options);
+        std::string signature = signingKey(2048).sign(challenge);
+        harness.run("debug/verifyChallenge_rsa2048_off", [&]() {
+            keep(quiet.verifyChallenge(quiet.currentConfig(), challenge, signature));
+        });
+        harness.run("debug/verifyChallenge_rsa2048_on", [&]() {
+            keep(debug.verifyChallenge(debug.currentConfig(), challenge, signature));
+        });
+
+        for (int threads : { 1, 8 }) {
+            std::string stage = "debug/log_threads" + std::to_string(threads);
+            if (!harness.selected(stage)) continue;
+
+            Logger logger(options);
+            std::atomic<bool> stop{ false };
+            std::atomic<uint64_t> operations{ 0 };
+            std::vector<std::thread> workers;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < threads; ++i) {
+                workers.emplace_back([&]() {
+                    uint64_t local = 0;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        logger.log(Logger::Level::Debug, "Signature verification succeeded!");
+                        ++local;
+                    }
+                    operations.fetch_add(local, std::memory_order_relaxed);
+                });
+            }
+            std::this_thread::sleep_for(harness.minTime());
+            stop = true;
+            for (std::thread& worker : workers) worker.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            logger.flush();
+
+            Logger::Stats stats = logger.stats();
+            harness.reportCounts(stage, seconds, {
+                { "calls", operations.load() },
+                { "logged", stats.logged },
+                { "dropped", stats.dropped },
+            });
+        }
+    }
+
+    // The runtime-configured LicenseGate against the same client with its policies fixed at
+    // compile time: challenges always on, debug output and the verdict cache compiled out.
+    // Both do the same work; only the checks for the features differ.
+    using FixedLicenseGate = BasicLicenseGate<LicenseGatePolicy::Enabled, LicenseGatePolicy::Disabled, LicenseGatePolicy::Disabled>;
+
+    static void policies(Harness& harness) {
+        if (!harness.selected("policy/")) return;
+
+        LicenseGate runtime(userId, signingKey(2048).publicPem);
+        FixedLicenseGate fixed(userId, signingKey(2048).publicPem);
+        policyStages(harness, "runtime", runtime);
+        policyStages(harness, "fixed", fixed);
+    }
+
+    template <typename Gate>
+    static void policyStages(Harness& harness, const std::string& variant, Gate& gate) {
+        harness.run("policy/buildUrl_" + variant, [&]() {
+            keep(gate.buildUrl(gate.currentConfig(), 0, licenseKey, "pro features", "host=build-01", challenge));
+        });
+
+        const std::pair<std::string, std::string> bodies[] = {
+            { "valid_rsa2048", "{\"valid\":true,\"result\":\"VALID\",\"signedChallenge\":\"" + signingKey(2048).sign(challenge) + "\"}" },
+            { "expired", "{\"valid\":false,\"result\":\"EXPIRED\"}" },
+        };
+        typename Gate::Response response;
+        std::string signedChallenge;
+        for (const auto& body : bodies) {
+            harness.run("policy/readResponse_" + body.first + "_" + variant, [&]() {
+                response.parser.reset();
+                response.parser.feed(body.second.data(), body.second.size());
+                keep(gate.readResponse(gate.currentConfig(), challenge, &response, signedChallenge));
+            });
+        }
+    }
+
+    // What a watched license costs on the request path. The server is unreachable, so the
+    // first refresh fails fast and publishes CONNECTION_ERROR; the read is the same either way.
+    static void watchedVerdict(Harness& harness) {
+        if (!harness.selected("watch/verdict")) return;
+
+        LicenseGate gate(userId);
+        gate.setValidationServer("http://127.0.0.1:9");
+        LicenseGate::WatchedLicense license = gate.watch(licenseKey, "", std::chrono::hours(1));
+        license.verdict();
+        harness.run("watch/verdict", [&]() {
+            keep(license.verdict());
+        });
+    }
+
+    // Heap allocations per call once the thread is warm. Each stage has a budget for C++,
+    // libcurl and OpenSSL allocations; going over any of them fails the run. The server stage runs only when LICENSEGATE_BENCH_SERVER is set.
+    static void allocations(Harness& harness) {
+        auto count = [&](const std::string& stage, Allocations::Counts budget, const std::function<void()>& call) {
+            if (!harness.selected(stage)) return;
+            for (int i = 0; i < 100; ++i) call();
+            const uint64_t calls = 1000;
+            Allocations::Counts start = Allocations::snapshot();
+            for (uint64_t i = 0; i < calls; ++i) call();
+            harness.reportAllocations(stage, calls, Allocations::since(start), budget);
+        };
+
+        LicenseGate plain(userId);
+        count("allocations/buildUrl", {}, [&]() {
+            keep(plain.buildUrl(plain.currentConfig(), 0, licenseKey, "pro features", "host=build-01", challenge));
+        });
+
+        std::string body = "{\"valid\":true,\"result\":\"VALID\",\"signedChallenge\":\"" + signingKey(2048).sign(challenge) + "\"}";
+        LicenseGate::Response response;
+        count("allocations/parseResponse", {}, [&]() {
+            response.parser.reset();
+            response.parser.feed(body.data(), body.size());
+            keep(response.parser.finish());
+        });
+
+        LicenseGate signedGate(userId, signingKey(2048).publicPem);
+        std::string signature = signingKey(2048).sign(challenge);
+        count("allocations/verifyChallenge_rsa2048", { 0, 0, 13 }, [&]() {
+            keep(signedGate.verifyChallenge(signedGate.currentConfig(), challenge, signature));
+        });
+
+        LicenseGate debug(userId, signingKey(2048).publicPem);
+        Logger::Options discard;
+        discard.sink = [](const Logger::Record&) {};
+        debug.enableDebug(discard);
+        count("allocations/verifyChallenge_rsa2048_debug", { 0, 0, 13 }, [&]() {
+            keep(debug.verifyChallenge(debug.currentConfig(), challenge, signature));
+        });
+
+        LicenseGate cached(userId);
+        cached.setValidationServer("http://127.0.0.1:9").enableCache();
+        cached.cacheVerdict(cached.currentConfig(), licenseKey, "", "", LicenseGate::ValidationType::VALID);
+        count("allocations/verify_cached", {}, [&]() {
+            keep(cached.verify(licenseKey));
+        });
+
+        const char* server = std::getenv("LICENSEGATE_BENCH_SERVER");
+        if (!server || !*server) return;
+        LicenseGate remote(userId);
+        remote.setValidationServer(server);
+        count("allocations/verify_server", { 0, 40, 0 }, [&]() {
+            if (remote.verify(licenseKey) == LicenseGate::ValidationType::CONNECTION_ERROR) throw std::runtime_error(std::string("allocations: verify failed to reach ") + server);
+        });
+    }
+
+    // Sequential verify latency against a local server, each call on a fresh instance with no
+    // open connection, or all of them on one instance whose pooled handle keeps its connection.
+    // Runs against LICENSEGATE_BENCH_SERVER and, with a trusted certificate, against
+    // LICENSEGATE_BENCH_TLS_SERVER, where a cold call also pays the full TLS handshake.
+    // Constructing the fresh instance is not timed.
+    static void verifyLatency(Harness& harness) {
+        for (const auto& target : { std::make_pair("LICENSEGATE_BENCH_SERVER", ""), std::make_pair("LICENSEGATE_BENCH_TLS_SERVER", "_tls") }) {
+            const char* server = std::getenv(target.first);
+            if (!server || !*server) continue;
+
+            for (bool pooled : { false, true }) {
+                std::string stage = std::string("latency/verify_") + (pooled ? "pooled" : "cold") + target.second;
+                if (!harness.selected(stage)) continue;
+
+                std::unique_ptr<LicenseGate> shared;
+                if (pooled) {
+                    shared.reset(new LicenseGate(userId));
+                    shared->setValidationServer(server);
+                    shared->verify(licenseKey);
+                }
+                std::vector<double> latencies;
+                auto end = std::chrono::steady_clock::now() + harness.minTime();
+                while (latencies.size() < 200 || std::chrono::steady_clock::now() < end) {
+                    std::unique_ptr<LicenseGate> fresh;
+                    if (!pooled) {
+                        fresh.reset(new LicenseGate(userId));
+                        fresh->setValidationServer(server);
+                    }
+                    LicenseGate& gate = pooled ? *shared : *fresh;
+                    auto start = std::chrono::steady_clock::now();
+                    if (gate.verify(licenseKey) == LicenseGate::ValidationType::CONNECTION_ERROR)
+                        throw std::runtime_error(stage + ": the request failed to reach " + server);
+                    latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                }
+                harness.reportLatencies(stage, latencies);
+            }
+        }
+    }
+
+    // Sequential verify latency against two or more local servers, with and without hedging.
+    // Runs only when LICENSEGATE_BENCH_SERVERS lists them, comma separated; the tails only
+    // differ if the servers stall now and then.
+    static void verifyTail(Harness& harness) {
+        const char* list = std::getenv("LICENSEGATE_BENCH_SERVERS");
+        if (!list || !*list) return;
+
+        std::vector<std::string> servers;
+        std::string rest = list;
+        for (size_t comma; (comma = rest.find(',')) != std::string::npos; rest.erase(0, comma + 1)) servers.push_back(rest.substr(0, comma));
+        servers.push_back(rest);
+
+        EndpointSelector::Options hedged;
+        hedged.hedge = true;
+        hedged.hedgePercentile = 0.9;
+        std::vector<std::pair<std::string, std::function<void(LicenseGate&)>>> variants = {
+            { "tail/verify_first_server", [&](LicenseGate& gate) { gate.setValidationServer(servers.front()); } },
+            { "tail/verify_selected", [&](LicenseGate& gate) { gate.setValidationServers(servers); } },
+            { "tail/verify_hedged_p90", [&](LicenseGate& gate) { gate.setValidationServers(servers, hedged); } },
+        };
+        for (const auto& variant : variants) {
+            if (!harness.selected(variant.first)) continue;
+
+            LicenseGate gate(userId);
+            variant.second(gate);
+            std::vector<double> latencies;
+            auto end = std::chrono::steady_clock::now() + harness.minTime();
+            for (uint64_t i = 0; std::chrono::steady_clock::now() < end; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                if (gate.verify(licenseKey + "-" + std::to_string(i)) == LicenseGate::ValidationType::CONNECTION_ERROR)
+                    throw std::runtime_error(variant.first + ": a request failed to reach the servers");
+                latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+            }
+            harness.reportLatencies(variant.first, latencies);
+        }
+    }
+
+    // An endpoint that fails now and then and stalls otherwise loses every hedge it is in. Those
+    // losses must not reset its breaker, so its failures still add up and the breaker opens.
+    // The end-to-end check runs only when LICENSEGATE_BENCH_SERVER is set: the bench puts a
+    // local endpoint in front of it that drops every other connection and stalls the rest.
+    static void hedgeBreaker(Harness& harness) {
+        EndpointSelector::Options options;
+        options.hedge = true;
+
+        std::string check = "hedge/breaker_opens_despite_lost_hedges";
+        if (harness.selected(check)) {
+            EndpointSelector endpoints({ "http://stalling", "http://healthy" }, options);
+            for (int i = 0; i < options.failureThreshold; ++i) {
+                if (endpoints.stats().endpoints[0].open) throw std::runtime_error(check + ": the breaker opened too early");
+                endpoints.record(0, std::chrono::milliseconds(1), false);
+                endpoints.recordAbandoned(0, std::chrono::milliseconds(50));
+            }
+            EndpointSelector::EndpointStats stalling = endpoints.stats().endpoints[0];
+            if (!stalling.open) throw std::runtime_error(check + ": lost hedges reset the breaker");
+            if (stalling.requests != static_cast<uint64_t>(options.failureThreshold) || stalling.latencySeconds < 0.001)
+                throw std::runtime_error(check + ": lost hedges were counted as requests or lowered the latency");
+            harness.reportCheck(check, options.failureThreshold);
+        }
+
+#ifndef _WIN32
+        const char* server = std::getenv("LICENSEGATE_BENCH_SERVER");
+        check = "hedge/stalled_endpoint_breaker_opens";
+        if (!server || !*server || !harness.selected(check)) return;
+
+        int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 64) != 0
+            || ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+            throw std::runtime_error(check + ": could not listen on a local port");
+
+        std::atomic<bool> stop{ false };
+        std::thread stalling([&]() {
+            std::vector<int> held;
+            for (uint64_t accepted = 0; !stop.load(std::memory_order_relaxed);) {
+                pollfd ready = { listener, POLLIN, 0 };
+                if (::poll(&ready, 1, 50) <= 0) continue;
+                int connection = ::accept(listener, nullptr, nullptr);
+                if (connection < 0) continue;
+                if (accepted++ % 2 == 0) ::close(connection);
+                else held.push_back(connection);
+            }
+            for (int connection : held) ::close(connection);
+        });
+
+        LicenseGate gate(userId);
+        gate.setValidationServers({ "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port)), server }, options);
+        uint64_t verifies = 0;
+        bool open = false;
+        for (auto end = std::chrono::steady_clock::now() + std::chrono::seconds(30); !open && std::chrono::steady_clock::now() < end; ++verifies) {
+            gate.verify(licenseKey, "", "", std::chrono::steady_clock::now() + std::chrono::milliseconds(200));
+            open = gate.endpointStats().endpoints[0].open;
+        }
+        stop = true;
+        stalling.join();
+        ::close(listener);
+        if (!open) throw std::runtime_error(check + ": the stalling endpoint's breaker never opened");
+        harness.reportCheck(check, verifies);
+#endif
+    }
+
+    // Time from constructing an instance to its first verdict, against a local HTTPS server.
+    // Runs only when LICENSEGATE_BENCH_TLS_SERVER is set and its certificate is trusted. Every
+    // iteration is a new instance with nothing cached in memory, like a restarted process;
+    // the prewarmed stage is the part of the first verify left once a prewarm has finished.
+    static void coldStart(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_TLS_SERVER");
+        if (!server || !*server) return;
+
+        std::string sessionFile = (std::filesystem::temp_directory_path() / "licensegate_bench_tls_sessions").string();
+        std::remove(sessionFile.c_str());
+        {
+            LicenseGate seed(userId);
+            seed.setValidationServer(server).enableTlsSessionCache(sessionFile);
+            seed.verify(licenseKey);
+        }
+
+        struct Variant {
+            std::string stage;
+            std::function<void(LicenseGate&)> setup;
+            bool timeSetup;
+        };
+        std::vector<Variant> variants = {
+            { "coldstart/first_verify", [](LicenseGate&) {}, true },
+            { "coldstart/first_verify_resumed", [&](LicenseGate& gate) { gate.enableTlsSessionCache(sessionFile); }, true },
+            { "coldstart/first_verify_prewarmed", [](LicenseGate& gate) { gate.prewarm(); }, false },
+        };
+        for (const Variant& variant : variants) {
+            if (!harness.selected(variant.stage)) continue;
+
+            std::vector<double> latencies;
+            auto end = std::chrono::steady_clock::now() + harness.minTime();
+            while (latencies.size() < 20 || std::chrono::steady_clock::now() < end) {
+                auto start = std::chrono::steady_clock::now();
+                LicenseGate gate(userId);
+                gate.setValidationServer(server);
+                variant.setup(gate);
+                if (!variant.timeSetup) start = std::chrono::steady_clock::now();
+                if (gate.verify(licenseKey) == LicenseGate::ValidationType::CONNECTION_ERROR)
+                    throw std::runtime_error(variant.stage + ": the request failed to reach " + server);
+                latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+            }
+            harness.reportLatencies(variant.stage, latencies);
+        }
+        std::remove(sessionFile.c_str());
+    }
+
+    // Closed-loop load from 16 threads against a server that answers RATE_LIMIT_EXCEEDED above
+    // LICENSEGATE_BENCH_RATE_LIMIT requests per second (default 100) for this userId. Runs only
+    // when LICENSEGATE_BENCH_RATE_LIMITED_SERVER is set. Counts valid verdicts, requests that
+    // reached the server and where the over-limit answers came from; the adaptive stage starts
+    // the client at twice the server's limit.
+    static void rateLimit(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_RATE_LIMITED_SERVER");
+        if (!server || !*server) return;
+        const char* limitText = std::getenv("LICENSEGATE_BENCH_RATE_LIMIT");
+        double limit = limitText && *limitText ? std::atof(limitText) : 100;
+
+        auto limiterOptions = [limit](double requestsPerSecond, RateLimiter::OverLimit overLimit, bool adaptive) {
+            RateLimiter::Options options;
+            options.requestsPerSecond = requestsPerSecond;
+            options.burst = std::max(1.0, limit / 10);
+            options.overLimit = overLimit;
+            options.adaptive = adaptive;
+            return options;
+        };
+        std::vector<std::pair<std::string, std::function<void(LicenseGate&)>>> variants = {
+            { "ratelimit/no_limiter", [](LicenseGate&) {} },
+            { "ratelimit/queue", [&](LicenseGate& gate) { gate.enableRateLimit(limiterOptions(limit, RateLimiter::OverLimit::Queue, true)); } },
+            { "ratelimit/fail_fast", [&](LicenseGate& gate) { gate.enableRateLimit(limiterOptions(limit, RateLimiter::OverLimit::FailFast, true)); } },
+            { "ratelimit/queue_adaptive_from_2x", [&](LicenseGate& gate) { gate.enableRateLimit(limiterOptions(2 * limit, RateLimiter::OverLimit::Queue, true)); } },
+        };
+        for (const auto& variant : variants) {
+            if (!harness.selected(variant.first)) continue;
+
+            LicenseGate gate(userId);
+            gate.setValidationServer(server).setConnectionPoolSize(16);
+            variant.second(gate);
+
+            // Let the server's bucket refill after the previous stage.
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::atomic<bool> stop{ false };
+            std::atomic<uint64_t> valid{ 0 };
+            std::atomic<uint64_t> limited{ 0 };
+            std::atomic<uint64_t> failed{ 0 };
+            std::vector<std::thread> workers;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < 16; ++i) {
+                workers.emplace_back([&, i]() {
+                    std::string key = licenseKey + "-" + std::to_string(i);
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        LicenseGate::ValidationType result = gate.verify(key);
+                        if (result == LicenseGate::ValidationType::VALID) valid.fetch_add(1, std::memory_order_relaxed);
+                        else if (result == LicenseGate::ValidationType::RATE_LIMIT_EXCEEDED) limited.fetch_add(1, std::memory_order_relaxed);
+                        else failed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+            }
+            std::this_thread::sleep_for(harness.minTime());
+            stop = true;
+            for (std::thread& worker : workers) worker.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (failed > 0) throw std::runtime_error(variant.first + ": " + std::to_string(failed.load()) + " requests failed to reach " + server);
+            RateLimiter::Stats limiter = gate.rateLimitStats();
+            uint64_t serverLimited = gate.currentConfig().rateLimiter ? limiter.serverLimited : limited.load();
+            harness.reportCounts(variant.first, seconds, {
+                { "valid", valid.load() },
+                { "server_requests", valid.load() + serverLimited },
+                { "server_rate_limited", serverLimited },
+                { "local_rejected", limiter.rejected },
+            });
+        }
+    }
+
+    // 64 threads verify the same few keys at once; the mock server must see exactly one
+    // request per key. Runs only when LICENSEGATE_BENCH_MOCK_SERVER is a licensegate_mock_server
+    // started with enough --latency-ms for every thread to arrive while the first request is
+    // still in flight.
+    static void coalescing(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_MOCK_SERVER");
+        if (!server || !*server) return;
+
+        const int threads = 64;
+        const int keys = 8;
+        const int rounds = 10;
+        std::string check = "coalesce/one_request_per_key_threads" + std::to_string(threads) + "_keys" + std::to_string(keys);
+        if (!harness.selected(check)) return;
+
+        LicenseGate gate(userId);
+        gate.setValidationServer(server).setConnectionPoolSize(keys);
+        auto start = std::chrono::steady_clock::now();
+        if (gate.verify(licenseKey) != LicenseGate::ValidationType::VALID) throw std::runtime_error(check + ": verify failed against " + server);
+        if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20))
+            throw std::runtime_error(check + ": the mock server answers too fast to overlap the threads; start it with --latency-ms=50");
+
+        for (int round = 0; round < rounds; ++round) {
+            uint64_t before = mockCounter(server, "requests");
+            std::atomic<bool> go{ false };
+            std::atomic<uint64_t> failures{ 0 };
+            std::vector<std::thread> workers;
+            for (int i = 0; i < threads; ++i) {
+                workers.emplace_back([&, i]() {
+                    std::string key = licenseKey + "-coalesce-" + std::to_string(round) + "-" + std::to_string(i % keys);
+                    while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                    if (gate.verify(key) != LicenseGate::ValidationType::VALID) failures.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+            go = true;
+            for (std::thread& worker : workers) worker.join();
+
+            uint64_t requests = mockCounter(server, "requests") - before;
+            if (failures > 0) throw std::runtime_error(check + ": " + std::to_string(failures.load()) + " verifications failed");
+            if (requests != keys)
+                throw std::runtime_error(check + ": the server saw " + std::to_string(requests) + " requests for " + std::to_string(keys) + " keys");
+        }
+        harness.reportCheck(check, static_cast<uint64_t>(rounds) * threads);
+    }
+
+    // Deadlines and cancellation against requests the mock server stalls halfway through the
+    // body, which it does for every key that starts with STALL-. Runs only when
+    // LICENSEGATE_BENCH_MOCK_SERVER is a licensegate_mock_server with the default --stall-ms.
+    static void deadlines(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_MOCK_SERVER");
+        if (!server || !*server || !harness.selected("deadline/")) return;
+
+        using Clock = std::chrono::steady_clock;
+        const auto slack = std::chrono::milliseconds(150);
+        auto cancelAfter = [](CancellationToken token, std::chrono::milliseconds delay) {
+            return std::thread([token, delay]() mutable {
+                std::this_thread::sleep_for(delay);
+                token.cancel();
+            });
+        };
+        auto expect = [](const std::string& check, bool passed, const std::string& detail) {
+            if (!passed) throw std::runtime_error(check + ": " + detail);
+        };
+        auto since = [](Clock::time_point start) { return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count()) + " ms"; };
+
+        LicenseGate gate(userId);
+        gate.setValidationServer(server);
+        if (gate.verify(licenseKey) != LicenseGate::ValidationType::VALID) throw std::runtime_error(std::string("deadline: verify failed against ") + server);
+
+        std::string check = "deadline/timeout_at_deadline";
+        if (harness.selected(check)) {
+            auto start = Clock::now();
+            LicenseGate::ValidationType result = gate.verify("STALL-" + licenseKey + "-timeout", "", "", start + std::chrono::milliseconds(200));
+            auto elapsed = Clock::now() - start;
+            expect(check, result == LicenseGate::ValidationType::TIMEOUT, "a stalled request gave " + std::to_string(static_cast<int>(result)));
+            expect(check, elapsed >= std::chrono::milliseconds(200) && elapsed < std::chrono::milliseconds(200) + slack, "TIMEOUT came after " + since(start));
+            harness.reportCheck(check, 1);
+        }
+
+        check = "deadline/cancelled_by_token";
+        if (harness.selected(check)) {
+            CancellationToken token;
+            std::thread canceller = cancelAfter(token, std::chrono::milliseconds(100));
+            auto start = Clock::now();
+            LicenseGate::ValidationType result = gate.verify("STALL-" + licenseKey + "-cancel", "", "", LicenseGate::Deadline::max(), token);
+            auto elapsed = Clock::now() - start;
+            canceller.join();
+            expect(check, result == LicenseGate::ValidationType::CANCELLED, "a stalled request gave " + std::to_string(static_cast<int>(result)));
+            expect(check, elapsed < std::chrono::milliseconds(100) + slack, "CANCELLED came after " + since(start));
+            harness.reportCheck(check, 1);
+        }
+
+        // The follower joins the leader's request, the leader is cancelled, and the follower
+        // must send the request again rather than take the leader's CANCELLED.
+        check = "deadline/follower_reruns_after_leader_cancelled";
+        if (harness.selected(check)) {
+            std::string key = "STALL-" + licenseKey + "-follower";
+            uint64_t before = mockCounter(server, "requests");
+            CancellationToken token;
+            LicenseGate::ValidationType leaderResult = LicenseGate::ValidationType::VALID;
+            std::thread leader([&]() { leaderResult = gate.verify(key, "", "", LicenseGate::Deadline::max(), token); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            std::thread canceller = cancelAfter(token, std::chrono::milliseconds(50));
+            auto start = Clock::now();
+            LicenseGate::ValidationType result = gate.verify(key, "", "", start + std::chrono::milliseconds(400));
+            leader.join();
+            canceller.join();
+            uint64_t requests = mockCounter(server, "requests") - before;
+            expect(check, leaderResult == LicenseGate::ValidationType::CANCELLED, "the leader gave " + std::to_string(static_cast<int>(leaderResult)));
+            expect(check, result == LicenseGate::ValidationType::TIMEOUT, "the follower gave " + std::to_string(static_cast<int>(result)));
+            expect(check, requests == 2, "the server saw " + std::to_string(requests) + " requests instead of 2");
+            harness.reportCheck(check, 1);
+        }
+
+        // A cancelled transfer closes its connection; the handle must still work afterwards and
+        // keep its next connection alive.
+        check = "deadline/pooled_handle_reused_after_cancel";
+        if (harness.selected(check)) {
+            const int cancels = 10;
+            for (int i = 0; i < cancels; ++i) {
+                CancellationToken token;
+                std::thread canceller = cancelAfter(token, std::chrono::milliseconds(5));
+                LicenseGate::ValidationType result = gate.verify("STALL-" + licenseKey + "-pool-" + std::to_string(i), "", "", LicenseGate::Deadline::max(), token);
+                canceller.join();
+                expect(check, result == LicenseGate::ValidationType::CANCELLED, "a cancelled request gave " + std::to_string(static_cast<int>(result)));
+            }
+            uint64_t before = mockCounter(server, "connections");
+            for (int i = 0; i < 5; ++i) {
+                LicenseGate::ValidationType result = gate.verify(licenseKey + "-pool-" + std::to_string(i));
+                expect(check, result == LicenseGate::ValidationType::VALID, "verify after a cancel gave " + std::to_string(static_cast<int>(result)));
+            }
+            uint64_t connections = mockCounter(server, "connections") - before;
+            expect(check, connections <= 1, std::to_string(connections) + " new connections for 5 requests");
+            harness.reportCheck(check, cancels);
+        }
+    }
+
+#ifndef _WIN32
+    struct ProcessResult {
+        uint64_t verifies = 0;
+        uint64_t failures = 0;
+        uint64_t serverRequests = 0;
+        uint64_t residentGrowthKb = 0;
+    };
+
+    static uint64_t residentKb() {
+#ifdef __linux__
+        std::ifstream statm("/proc/self/statm");
+        uint64_t size = 0;
+        uint64_t resident = 0;
+        statm >> size >> resident;
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+        return 0;
+#endif
+    }
+
+    // Forks the workers while the parent is still single-threaded, then releases them together
+    // once startParent has run. Each worker builds its own state after the fork and works until
+    // the duration is up.
+    static std::vector<ProcessResult> runProcesses(int count, std::chrono::milliseconds duration, const std::function<void()>& startParent,
+        const std::function<ProcessResult(std::chrono::steady_clock::time_point)>& work) {
+        int go[2];
+        if (pipe(go) != 0) throw std::runtime_error("sidecar: pipe failed");
+        std::vector<std::pair<pid_t, int>> children;
+        for (int i = 0; i < count; ++i) {
+            int result[2];
+            if (pipe(result) != 0) throw std::runtime_error("sidecar: pipe failed");
+            pid_t pid = fork();
+            if (pid < 0) throw std::runtime_error("sidecar: fork failed");
+            if (pid == 0) {
+                ::close(go[1]);
+                ::close(result[0]);
+                char ignored;
+                while (::read(go[0], &ignored, 1) > 0) {}
+                ProcessResult outcome;
+                try {
+                    uint64_t before = residentKb();
+                    outcome = work(std::chrono::steady_clock::now() + duration);
+                    outcome.residentGrowthKb = residentKb() - std::min(before, residentKb());
+                }
+                catch (...) {
+                    _exit(1);
+                }
+                bool written = ::write(result[1], &outcome, sizeof(outcome)) == static_cast<ssize_t>(sizeof(outcome));
+                _exit(written ? 0 : 1);
+            }
+            ::close(result[1]);
+            children.emplace_back(pid, result[0]);
+        }
+
+        startParent();
+        ::close(go[0]);
+        ::close(go[1]);
+
+        std::vector<ProcessResult> results;
+        bool complete = true;
+        for (const auto& child : children) {
+            ProcessResult outcome;
+            complete = ::read(child.second, &outcome, sizeof(outcome)) == static_cast<ssize_t>(sizeof(outcome)) && complete;
+            results.push_back(outcome);
+            ::close(child.second);
+            int status = 0;
+            waitpid(child.first, &status, 0);
+        }
+        if (!complete) throw std::runtime_error("sidecar: a worker process failed");
+        return results;
+    }
+
+    // Many processes on one host verifying the same licenses, each with its own cached
+    // LicenseGate or as clients of one sidecar daemon, with and without its shared table.
+    // Runs only when LICENSEGATE_BENCH_SERVER is set.
+    static void sidecar(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_SERVER");
+        if (!server || !*server) return;
+
+        const int processes = 16;
+        const int keys = 64;
+        std::string base = "/tmp/licensegate_bench_" + std::to_string(getpid());
+        SidecarClient::Options clientOptions;
+        clientOptions.socketPath = base + ".sock";
+
+        auto loop = [&](const std::function<LicenseGate::ValidationType(const std::string&)>& verify, std::chrono::steady_clock::time_point until) {
+            ProcessResult result;
+            std::vector<std::string> licenses;
+            for (int i = 0; i < keys; ++i) licenses.push_back(licenseKey + "-" + std::to_string(i));
+            for (size_t i = 0; std::chrono::steady_clock::now() < until; ++i) {
+                if (verify(licenses[i % licenses.size()]) == LicenseGate::ValidationType::VALID) ++result.verifies;
+                else ++result.failures;
+            }
+            return result;
+        };
+        auto report = [&](const std::string& stage, const std::vector<ProcessResult>& results, uint64_t daemonRequests, double seconds) {
+            uint64_t verifies = 0;
+            uint64_t failures = 0;
+            uint64_t serverRequests = daemonRequests;
+            double resident = 0;
+            for (const ProcessResult& result : results) {
+                verifies += result.verifies;
+                failures += result.failures;
+                serverRequests += result.serverRequests;
+                resident += static_cast<double>(result.residentGrowthKb) / results.size();
+            }
+            if (failures > 0) throw std::runtime_error(stage + ": " + std::to_string(failures) + " verifications failed");
+            harness.reportProcesses(stage, processes, seconds, { { "verifies", verifies }, { "server_requests", serverRequests } }, resident);
+        };
+
+        std::string stage = "sidecar/embedded_procs" + std::to_string(processes);
+        if (harness.selected(stage)) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<ProcessResult> results = runProcesses(processes, harness.minTime(), []() {}, [&](std::chrono::steady_clock::time_point until) {
+                LicenseGate gate(userId);
+                gate.setValidationServer(server).enableCache();
+                ProcessResult result = loop([&gate](const std::string& key) { return gate.verify(key); }, until);
+                result.serverRequests = gate.stats().phase(Metrics::Phase::Server).count;
+                return result;
+            });
+            report(stage, results, 0, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        for (bool shared : { false, true }) {
+            stage = std::string("sidecar/daemon_") + (shared ? "table" : "socket") + "_procs" + std::to_string(processes);
+            if (!harness.selected(stage)) continue;
+
+            LicenseGate gate(userId);
+            gate.setValidationServer(server).setConnectionPoolSize(processes).enableCache();
+            SidecarServer::Options serverOptions;
+            serverOptions.socketPath = clientOptions.socketPath;
+            if (shared) serverOptions.tablePath = base + ".table";
+            SidecarServer daemon(gate, serverOptions);
+            clientOptions.tablePath = serverOptions.tablePath;
+
+            std::thread serving;
+            auto start = std::chrono::steady_clock::now();
+            std::vector<ProcessResult> results = runProcesses(processes, harness.minTime(), [&]() { serving = std::thread([&daemon]() { daemon.run(); }); },
+                [&](std::chrono::steady_clock::time_point until) {
+                    SidecarClient client(clientOptions);
+                    return loop([&client](const std::string& key) { return client.verify(key); }, until);
+                });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            daemon.stop();
+            serving.join();
+            if (shared) ::unlink(serverOptions.tablePath.c_str());
+            report(stage, results, gate.stats().phase(Metrics::Phase::Server).count, seconds);
+        }
+    }
+#endif
+
+    // Throughput of one shared instance against a local server, e.g. the mock server. Runs only
+    // when LICENSEGATE_BENCH_SERVER is set; each thread verifies its own license key so that
+    // request coalescing does not merge the calls.
+    static void verifyScaling(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_SERVER");
+        if (!server || !*server) return;
+
+        LicenseGate gate(userId);
+        gate.setValidationServer(server);
+        gate.setConnectionPoolSize(64);
+
+        for (int threads : { 1, 2, 4, 8, 16, 32, 64 }) {
+            std::string stage = "scaling/verify_threads" + std::to_string(threads);
+            if (!harness.selected(stage)) continue;
+
+            std::atomic<bool> stop{ false };
+            std::atomic<uint64_t> operations{ 0 };
+            std::atomic<uint64_t> failures{ 0 };
+            std::vector<std::thread> workers;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < threads; ++i) {
+                workers.emplace_back([&, i]() {
+                    std::string key = licenseKey + "-" + std::to_string(i);
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        if (gate.verify(key) == LicenseGate::ValidationType::CONNECTION_ERROR) failures.fetch_add(1, std::memory_order_relaxed);
+                        operations.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+            }
+            std::this_thread::sleep_for(harness.minTime());
+            stop = true;
+            for (std::thread& worker : workers) worker.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (failures > 0) throw std::runtime_error(stage + ": " + std::to_string(failures.load()) + " requests failed to reach " + server);
+            harness.reportThroughput(stage, threads, operations, seconds);
+        }
+    }
+
+    // verifyBatch throughput from one calling thread with 1 to 256 requests in flight, against
+    // a local server. Runs only when LICENSEGATE_BENCH_SERVER is set; every request in a batch
+    // has its own license key so that none of them are coalesced.
+    static void verifyBatch(Harness& harness) {
+        const char* server = std::getenv("LICENSEGATE_BENCH_SERVER");
+        if (!server || !*server) return;
+
+        std::vector<LicenseGate::BatchRequest> requests;
+        for (int i = 0; i < 1024; ++i) requests.push_back({ licenseKey + "-" + std::to_string(i), "", "" });
+
+        for (size_t inFlight : { 1, 16, 64, 256 }) {
+            std::string stage = "batch/verifyBatch_in_flight" + std::to_string(inFlight);
+            if (!harness.selected(stage)) continue;
+
+            LicenseGate gate(userId);
+            gate.setValidationServer(server).setBatchConcurrency(inFlight);
+            gate.verifyBatch(std::vector<LicenseGate::BatchRequest>(requests.begin(), requests.begin() + inFlight)); // open the connections
+
+            uint64_t operations = 0;
+            auto start = std::chrono::steady_clock::now();
+            auto end = start + harness.minTime();
+            do {
+                for (LicenseGate::ValidationType result : gate.verifyBatch(requests)) {
+                    if (result == LicenseGate::ValidationType::CONNECTION_ERROR)
+                        throw std::runtime_error(stage + ": a request failed to reach " + server);
+                }
+                operations += requests.size();
+            } while (std::chrono::steady_clock::now() < end);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            harness.reportThroughput(stage, 1, operations, seconds);
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    if (!Allocations::install()) {
+        std::cerr << "licensegate_bench: could not hook the libcurl and OpenSSL allocators" << std::endl;
+        return 1;
+    }
+
+    Harness::Options options;
+    if (!Harness::parseArguments(argc, argv, options)) return 2;
+
+    try {
+        Harness harness(options);
+        LicenseGateBenchmark::run(harness);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "licensegate_bench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <LicenseGate.hpp>
+#include <SidecarServer.hpp>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <pthread.h>
+
+// Verifies licenses for every process on the host. Clients connect with SidecarClient to the
+// same socket and table paths. Stops on SIGINT or SIGTERM.
+namespace {
+    void usage(const char* program) {
+        std::cerr << "usage: " << program << " --user=ID --socket=PATH [--table=PATH] [--table-slots=N] [--public-key=FILE]"
+            " [--server=URL]... [--challenges] [--valid-ttl-s=N] [--negative-ttl-s=N] [--socket-mode=OCTAL]"
+            " [--table-mode=OCTAL]" << std::endl;
+    }
+
+    bool readFile(const std::string& path, std::string& contents) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string userId;
+    std::string publicKeyPath;
+    std::vector<std::string> servers;
+    bool challenges = false;
+    SidecarServer::Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        auto value = [&argument](size_t prefix) { return argument.substr(prefix); };
+        if (argument.rfind("--user=", 0) == 0) userId = value(7);
+        else if (argument.rfind("--socket=", 0) == 0) options.socketPath = value(9);
+        else if (argument.rfind("--table=", 0) == 0) options.tablePath = value(8);
+        else if (argument.rfind("--table-slots=", 0) == 0) options.tableSlots = std::strtoul(argument.c_str() + 14, nullptr, 10);
+        else if (argument.rfind("--public-key=", 0) == 0) publicKeyPath = value(13);
+        else if (argument.rfind("--server=", 0) == 0) servers.push_back(value(9));
+        else if (argument == "--challenges") challenges = true;
+        else if (argument.rfind("--valid-ttl-s=", 0) == 0) options.validTtl = std::chrono::seconds(std::atol(argument.c_str() + 14));
+        else if (argument.rfind("--negative-ttl-s=", 0) == 0) options.negativeTtl = std::chrono::seconds(std::atol(argument.c_str() + 17));
+        else if (argument.rfind("--socket-mode=", 0) == 0) options.socketMode = static_cast<uint32_t>(std::strtoul(argument.c_str() + 14, nullptr, 8));
+        else if (argument.rfind("--table-mode=", 0) == 0) options.tableMode = static_cast<uint32_t>(std::strtoul(argument.c_str() + 13, nullptr, 8));
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (userId.empty() || options.socketPath.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::string publicKey;
+    if (!publicKeyPath.empty() && !readFile(publicKeyPath, publicKey)) {
+        std::cerr << "licensegate_sidecar: cannot read " << publicKeyPath << std::endl;
+        return 1;
+    }
+
+    // Block the stop signals before any thread starts, so that only sigwait sees them.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    try {
+        LicenseGate gate(userId);
+        if (!publicKey.empty()) gate.setPublicRsaKey(publicKey);
+        if (!servers.empty()) gate.setValidationServers(servers);
+        if (challenges) gate.enableChallenges();
+        gate.enablePrewarm();
+
+        SidecarServer server(gate, options);
+        std::thread serving([&server]() { server.run(); });
+
+        int signal = 0;
+        sigwait(&stopSignals, &signal);
+        server.stop();
+        serving.join();
+
+        SidecarServer::Stats stats = server.stats();
+        std::cerr << "licensegate_sidecar: served " << stats.requests << " requests on " << stats.connections << " connections" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "licensegate_sidecar: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+LatencyHistogram::LatencyHistogram() : counts(subBucketCount + maxShift * subBucketHalf, 0) {
+}
+
+// Below subBucketCount the index is the value. Above it, a value with its top bit at position
+// subBucketBits + shift - 1 keeps its top subBucketBits bits, whose upper half identifies it.
+size_t LatencyHistogram::indexOf(uint64_t value) {
+    if (value < subBucketCount) return static_cast<size_t>(value);
+    unsigned shift = 0;
+    while ((value >> shift) >= subBucketCount) ++shift;
+    return static_cast<size_t>(subBucketCount + (shift - 1) * subBucketHalf + ((value >> shift) - subBucketHalf));
+}
+
+uint64_t LatencyHistogram::lowestAt(size_t index) {
+    if (index < subBucketCount) return index;
+    uint64_t shift = (index - subBucketCount) / subBucketHalf + 1;
+    uint64_t sub = (index - subBucketCount) % subBucketHalf + subBucketHalf;
+    return sub << shift;
+}
+
+uint64_t LatencyHistogram::highestAt(size_t index) {
+    if (index < subBucketCount) return index;
+    uint64_t shift = (index - subBucketCount) / subBucketHalf + 1;
+    return lowestAt(index) + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) {
+    uint64_t nanoseconds = static_cast<uint64_t>(std::max<int64_t>(value.count(), 0));
+    nanoseconds = std::min(nanoseconds, maxTrackable);
+    ++counts[indexOf(nanoseconds)];
+    ++total;
+    minValue = std::min(minValue, nanoseconds);
+    maxValue = std::max(maxValue, nanoseconds);
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+    total += other.total;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+double LatencyHistogram::mean() const {
+    if (total == 0) return 0;
+    double sum = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i]) sum += counts[i] * (lowestAt(i) + highestAt(i)) / 2.0;
+    }
+    return sum / total;
+}
+
+double LatencyHistogram::standardDeviation() const {
+    if (total == 0) return 0;
+    double average = mean();
+    double squares = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (!counts[i]) continue;
+        double deviation = (lowestAt(i) + highestAt(i)) / 2.0 - average;
+        squares += counts[i] * deviation * deviation;
+    }
+    return std::sqrt(squares / total);
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+    if (total == 0) return 0;
+    double clamped = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t wanted = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100 * total)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= wanted) return std::min(highestAt(i), maxValue);
+    }
+    return maxValue;
+}
+
+void LatencyHistogram::writePercentiles(std::ostream& out, double unitNanoseconds) const {
+    char line[128];
+    out << "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+    auto countUpTo = [this](uint64_t value) {
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size() && lowestAt(i) <= value; ++i) seen += counts[i];
+        return seen;
+    };
+    auto emit = [&](double fraction) {
+        uint64_t value = valueAtPercentile(fraction * 100);
+        if (fraction < 1) std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu %14.2f\n", value / unitNanoseconds, fraction,
+            static_cast<unsigned long long>(countUpTo(value)), 1 / (1 - fraction));
+        else std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu\n", value / unitNanoseconds, fraction, static_cast<unsigned long long>(total));
+        out << line;
+    };
+
+    // Five steps per halving of the distance to 100%, as HdrHistogram prints them by default.
+    if (total > 0) {
+        for (int half = 0; (1 - std::pow(0.5, half)) * total < total - 1 && half < 40; ++half) {
+            double from = 1 - std::pow(0.5, half);
+            double to = 1 - std::pow(0.5, half + 1);
+            for (int step = 0; step < 5; ++step) emit(from + (to - from) * step / 5);
+        }
+        emit(1);
+    }
+
+    std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean() / unitNanoseconds, standardDeviation() / unitNanoseconds);
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Max     = %12.3f, Total count    = %12llu]\n", max() / unitNanoseconds, static_cast<unsigned long long>(total));
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Buckets = %12u, SubBuckets     = %12llu]\n", maxShift + 1, static_cast<unsigned long long>(subBucketCount));
+    out << line;
+}
@@ -0,0 +1,48 @@
+#ifndef LICENSE_GATE_TOOLS_LATENCY_HISTOGRAM_H
+#define LICENSE_GATE_TOOLS_LATENCY_HISTOGRAM_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Latency histogram with HdrHistogram's layout: values up to 2047 ns are counted exactly and
+// larger ones to within 0.1%, up to about two hours, in a fixed 272 KiB. Recording is not
+// thread-safe; give each thread its own histogram and add them up afterwards.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds value);
+    void add(const LatencyHistogram& other);
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const;
+    double standardDeviation() const;
+    // Highest value equivalent to the one at the given percentile (0 to 100), in nanoseconds.
+    uint64_t valueAtPercentile(double percentile) const;
+
+    // HdrHistogram's percentile distribution format (.hgrm), which its plotter reads. Values
+    // are divided by unitNanoseconds, e.g. 1000 for microseconds.
+    void writePercentiles(std::ostream& out, double unitNanoseconds) const;
+
+private:
+    static constexpr unsigned subBucketBits = 11;
+    static constexpr uint64_t subBucketCount = uint64_t(1) << subBucketBits;
+    static constexpr uint64_t subBucketHalf = subBucketCount / 2;
+    static constexpr unsigned maxShift = 32;
+    static constexpr uint64_t maxTrackable = (subBucketCount << maxShift) - 1;
+
+    static size_t indexOf(uint64_t value);
+    static uint64_t lowestAt(size_t index);
+    static uint64_t highestAt(size_t index);
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t minValue = UINT64_MAX;
+    uint64_t maxValue = 0;
+};
+
+#endif // LICENSE_GATE_TOOLS_LATENCY_HISTOGRAM_H
@@ -0,0 +1,312 @@
+#include "LatencyHistogram.hpp"
+#include <LicenseGate.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Replays a corpus of license keys through LicenseGate, either with a fixed number of requests
+// in flight (closed loop) or at a fixed request rate (open loop), and reports throughput, the
+// result counts and latency percentiles as one JSON line. In open-loop mode latency is measured
+// from when a request was due, not from when it was sent, so a client that falls behind shows
+// the queueing delay instead of hiding it.
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::string server = "http://127.0.0.1:8080";
+        std::string userId = "loadgen";
+        std::string keysPath;
+        size_t generatedKeys = 1000;
+        std::string publicKeyPath;
+        bool challenges = false;
+        bool cache = false;
+        bool async = false;
+        size_t concurrency = 16;
+        double rate = 0;
+        std::chrono::milliseconds duration = std::chrono::seconds(10);
+        std::chrono::milliseconds warmup = std::chrono::seconds(1);
+        // Per-request deadline for verify, counted from when the request was due; 0 for none.
+        std::chrono::milliseconds requestDeadline{ 0 };
+        std::string histogramPath;
+    };
+
+    void usage(const char* program) {
+        std::cerr << "usage: " << program << " [--server=URL] [--user=ID] [--keys=FILE | --generate-keys=N] [--public-key=FILE] [--challenges]"
+            " [--cache] [--async] [--concurrency=N] [--rate=RPS] [--duration-s=N] [--warmup-s=N] [--deadline-ms=N] [--histogram=FILE]\n"
+            "  --keys reads one request per line: key, or key<TAB>scope<TAB>metadata\n"
+            "  --rate switches from a closed loop with N requests in flight to N workers sending at a fixed rate\n"
+            "  --deadline-ms gives each verify a deadline; not supported with --async" << std::endl;
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            auto seconds = [&argument](size_t prefix) { return std::chrono::milliseconds(static_cast<int64_t>(std::atof(argument.c_str() + prefix) * 1000)); };
+            if (argument.rfind("--server=", 0) == 0) options.server = argument.substr(9);
+            else if (argument.rfind("--user=", 0) == 0) options.userId = argument.substr(7);
+            else if (argument.rfind("--keys=", 0) == 0) options.keysPath = argument.substr(7);
+            else if (argument.rfind("--generate-keys=", 0) == 0) options.generatedKeys = std::strtoul(argument.c_str() + 16, nullptr, 10);
+            else if (argument.rfind("--public-key=", 0) == 0) options.publicKeyPath = argument.substr(13);
+            else if (argument == "--challenges") options.challenges = true;
+            else if (argument == "--cache") options.cache = true;
+            else if (argument == "--async") options.async = true;
+            else if (argument.rfind("--concurrency=", 0) == 0) options.concurrency = std::strtoul(argument.c_str() + 14, nullptr, 10);
+            else if (argument.rfind("--rate=", 0) == 0) options.rate = std::atof(argument.c_str() + 7);
+            else if (argument.rfind("--duration-s=", 0) == 0) options.duration = seconds(13);
+            else if (argument.rfind("--warmup-s=", 0) == 0) options.warmup = seconds(11);
+            else if (argument.rfind("--deadline-ms=", 0) == 0) options.requestDeadline = std::chrono::milliseconds(std::strtoll(argument.c_str() + 14, nullptr, 10));
+            else if (argument.rfind("--histogram=", 0) == 0) options.histogramPath = argument.substr(12);
+            else return false;
+        }
+        return options.concurrency > 0 && options.duration.count() > 0 && options.generatedKeys > 0
+            && !(options.async && options.requestDeadline.count() > 0);
+    }
+
+    bool loadCorpus(const Options& options, std::vector<LicenseGate::BatchRequest>& corpus) {
+        if (options.keysPath.empty()) {
+            for (size_t i = 0; i < options.generatedKeys; ++i) corpus.push_back({ "loadgen-key-" + std::to_string(i), "", "" });
+            return true;
+        }
+        std::ifstream in(options.keysPath);
+        if (!in) return false;
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            LicenseGate::BatchRequest request;
+            std::istringstream fields(line);
+            std::getline(fields, request.licenseKey, '\t');
+            std::getline(fields, request.scope, '\t');
+            std::getline(fields, request.metadata, '\t');
+            corpus.push_back(request);
+        }
+        return !corpus.empty();
+    }
+
+    // What one thread measured. Each thread records into its own histogram; they are added up
+    // at the end.
+    struct Recorder {
+        LatencyHistogram latency;
+        std::vector<uint64_t> results = std::vector<uint64_t>(static_cast<size_t>(LicenseGate::ValidationType::CANCELLED) + 1, 0);
+
+        void record(LicenseGate::ValidationType result, Clock::duration latency) {
+            this->latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+            ++results[static_cast<size_t>(result)];
+        }
+    };
+
+    // Issues requests until the deadline and records those started after measureFrom. Returns
+    // the time the last recorded request finished.
+    class Run {
+    public:
+        Run(const Options& options, LicenseGate& gate, const std::vector<LicenseGate::BatchRequest>& corpus)
+            : options(options), gate(gate), corpus(corpus) {}
+
+        std::vector<Recorder> execute(Clock::time_point start) {
+            measureFrom = start + options.warmup;
+            deadline = measureFrom + options.duration;
+            if (options.async) return options.rate > 0 ? asyncOpenLoop(start) : asyncClosedLoop();
+            return syncWorkers(start);
+        }
+
+    private:
+        const LicenseGate::BatchRequest& next() {
+            return corpus[sequence.fetch_add(1, std::memory_order_relaxed) % corpus.size()];
+        }
+
+        Clock::time_point dueAt(Clock::time_point start, uint64_t index) const {
+            return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(index / options.rate));
+        }
+
+        // Closed loop: each worker sends its next request as soon as the last one returns. Open
+        // loop: the workers share one schedule and each request is timed from when it was due.
+        std::vector<Recorder> syncWorkers(Clock::time_point start) {
+            std::vector<Recorder> recorders(options.concurrency);
+            std::atomic<uint64_t> ticket{ 0 };
+            std::vector<std::thread> workers;
+            for (size_t w = 0; w < options.concurrency; ++w) {
+                workers.emplace_back([&, w]() {
+                    for (;;) {
+                        Clock::time_point due = Clock::now();
+                        if (options.rate > 0) {
+                            due = dueAt(start, ticket.fetch_add(1, std::memory_order_relaxed));
+                            if (due >= deadline) return;
+                            std::this_thread::sleep_until(due);
+                        }
+                        else if (due >= deadline) return;
+
+                        const LicenseGate::BatchRequest& request = next();
+                        LicenseGate::ValidationType result = options.requestDeadline.count() > 0
+                            ? gate.verify(request.licenseKey, request.scope, request.metadata, due + options.requestDeadline)
+                            : gate.verify(request.licenseKey, request.scope, request.metadata);
+                        if (due >= measureFrom) recorders[w].record(result, Clock::now() - due);
+                    }
+                });
+            }
+            for (std::thread& worker : workers) worker.join();
+            return recorders;
+        }
+
+        // Keeps concurrency requests in flight; each callback sends the next one.
+        std::vector<Recorder> asyncClosedLoop() {
+            std::vector<Recorder> recorders(1);
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t inFlight = 0;
+
+            std::function<void()> send = [&]() {
+                Clock::time_point sent = Clock::now();
+                const LicenseGate::BatchRequest& request = next();
+                gate.verifyAsync(request.licenseKey, request.scope, request.metadata, [&, sent](LicenseGate::ValidationType result) {
+                    Clock::time_point now = Clock::now();
+                    bool again = now < deadline;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (sent >= measureFrom) recorders[0].record(result, now - sent);
+                        if (!again && --inFlight == 0) finished.notify_all();
+                    }
+                    if (again) send();
+                });
+            };
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inFlight = options.concurrency;
+            }
+            for (size_t i = 0; i < options.concurrency; ++i) send();
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&]() { return inFlight == 0; });
+            return recorders;
+        }
+
+        // One thread sends on schedule without waiting for answers; concurrency is not capped.
+        std::vector<Recorder> asyncOpenLoop(Clock::time_point start) {
+            std::vector<Recorder> recorders(1);
+            std::mutex mutex;
+            std::condition_variable finished;
+            uint64_t outstanding = 0;
+
+            for (uint64_t index = 0;; ++index) {
+                Clock::time_point due = dueAt(start, index);
+                if (due >= deadline) break;
+                std::this_thread::sleep_until(due);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++outstanding;
+                }
+                const LicenseGate::BatchRequest& request = next();
+                gate.verifyAsync(request.licenseKey, request.scope, request.metadata, [&, due](LicenseGate::ValidationType result) {
+                    Clock::duration latency = Clock::now() - due;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (due >= measureFrom) recorders[0].record(result, latency);
+                    if (--outstanding == 0) finished.notify_all();
+                });
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&]() { return outstanding == 0; });
+            return recorders;
+        }
+
+        const Options& options;
+        LicenseGate& gate;
+        const std::vector<LicenseGate::BatchRequest>& corpus;
+        std::atomic<uint64_t> sequence{ 0 };
+        Clock::time_point measureFrom;
+        Clock::time_point deadline;
+    };
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::vector<LicenseGate::BatchRequest> corpus;
+    if (!loadCorpus(options, corpus)) {
+        std::cerr << "licensegate_loadgen: cannot read any keys from " << options.keysPath << std::endl;
+        return 1;
+    }
+
+    LicenseGate gate(options.userId);
+    if (!options.publicKeyPath.empty()) {
+        std::string publicKey = readFile(options.publicKeyPath);
+        if (publicKey.empty()) {
+            std::cerr << "licensegate_loadgen: cannot read " << options.publicKeyPath << std::endl;
+            return 1;
+        }
+        gate.setPublicRsaKey(publicKey);
+    }
+    gate.setValidationServer(options.server).setConnectionPoolSize(options.concurrency).setBatchConcurrency(options.concurrency);
+    if (options.challenges) gate.enableChallenges();
+    if (options.cache) gate.enableCache();
+
+    Run run(options, gate, corpus);
+    Clock::time_point start = Clock::now();
+    std::vector<Recorder> recorders = run.execute(start);
+
+    Recorder total;
+    for (const Recorder& recorder : recorders) {
+        total.latency.add(recorder.latency);
+        for (size_t i = 0; i < total.results.size(); ++i) total.results[i] += recorder.results[i];
+    }
+
+    // Result names in ValidationType order, as the client's metrics report them.
+    Metrics::Stats metrics = gate.stats();
+    json results = json::object();
+    for (size_t i = 0; i < total.results.size() && i < metrics.results.size(); ++i) {
+        if (total.results[i] > 0) results[metrics.results[i].first] = total.results[i];
+    }
+
+    double seconds = std::chrono::duration<double>(options.duration).count();
+    auto microseconds = [&total](double percentile) { return total.latency.valueAtPercentile(percentile) / 1000.0; };
+    json report = {
+        { "mode", options.rate > 0 ? "open_loop" : "closed_loop" },
+        { "api", options.async ? "async" : "sync" },
+        { "concurrency", options.concurrency },
+        { "target_rate", options.rate },
+        { "deadline_ms", options.requestDeadline.count() },
+        { "seconds", seconds },
+        { "corpus", corpus.size() },
+        { "requests", total.latency.count() },
+        { "throughput", total.latency.count() / seconds },
+        { "results", results },
+        { "server_requests", metrics.phase(Metrics::Phase::Server).count },
+        { "latency_us", {
+            { "min", total.latency.min() / 1000.0 },
+            { "mean", total.latency.mean() / 1000.0 },
+            { "p50", microseconds(50) },
+            { "p90", microseconds(90) },
+            { "p99", microseconds(99) },
+            { "p99_9", microseconds(99.9) },
+            { "p99_99", microseconds(99.99) },
+            { "max", total.latency.max() / 1000.0 },
+        } },
+    };
+    std::cout << report.dump() << std::endl;
+
+    if (!options.histogramPath.empty()) {
+        std::ofstream out(options.histogramPath);
+        total.latency.writePercentiles(out, 1000);
+        if (!out) {
+            std::cerr << "licensegate_loadgen: cannot write " << options.histogramPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
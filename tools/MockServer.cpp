@@ -0,0 +1,414 @@
+#include <RateLimiter.hpp>
+#include <atomic>
+#include <cctype>
+#include <csignal>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// A local stand-in for the LicenseGate API, for load tests that must not reach
+// api.licensegate.io. It answers GET and HEAD on /license/{userId}/{key}/verify with the same
+// JSON as the real server and signs the challenge with its own RSA key. Latency, errors,
+// stalls and per-user rate limiting can be injected. A key starting with a result name and a
+// dash, such as EXPIRED-1234, gets that result; every other key is VALID. A key starting with
+// STALL- always stalls. GET /stats returns counters. With --tls-cert and --tls-key it serves
+// HTTPS instead, so the handshake and session resumption are part of what is measured.
+namespace {
+    struct Options {
+        std::string bind = "127.0.0.1";
+        int port = 8080;
+        std::string privateKeyPath;
+        std::string publicKeyOut;
+        double latencyMs = 0;
+        double jitterMs = 0;
+        double slowRate = 0;
+        double slowMs = 0;
+        double errorRate = 0;
+        double dropRate = 0;
+        // A stalled response stops halfway through the body for stallMs.
+        double stallRate = 0;
+        double stallMs = 60000;
+        double rateLimit = 0;
+        double burst = 0;
+        std::string tlsCertificate;
+        std::string tlsKey;
+    };
+
+    const char* const resultNames[] = {
+        "VALID", "NOT_FOUND", "NOT_ACTIVE", "EXPIRED", "LICENSE_SCOPE_FAILED", "IP_LIMIT_EXCEEDED", "RATE_LIMIT_EXCEEDED",
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> requests{ 0 };
+        std::atomic<uint64_t> rateLimited{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> stalled{ 0 };
+        std::atomic<uint64_t> connections{ 0 };
+    };
+
+    Options options;
+    Counters counters;
+    std::shared_ptr<EVP_PKEY> signingKey;
+    std::shared_ptr<SSL_CTX> tlsContext;
+    std::mutex limitersMutex;
+    std::unordered_map<std::string, std::unique_ptr<RateLimiter>> limiters;
+
+    void usage(const char* program) {
+        std::cerr << "usage: " << program << " [--port=N] [--bind=ADDRESS] [--private-key=FILE] [--public-key-out=FILE]"
+            " [--latency-ms=N] [--jitter-ms=N] [--slow-rate=F --slow-ms=N] [--error-rate=F] [--drop-rate=F]"
+            " [--stall-rate=F] [--stall-ms=N] [--rate-limit=RPS [--burst=N]] [--tls-cert=FILE --tls-key=FILE]" << std::endl;
+    }
+
+    bool parseArguments(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            auto number = [&argument](size_t prefix) { return std::atof(argument.c_str() + prefix); };
+            if (argument.rfind("--port=", 0) == 0) options.port = std::atoi(argument.c_str() + 7);
+            else if (argument.rfind("--bind=", 0) == 0) options.bind = argument.substr(7);
+            else if (argument.rfind("--private-key=", 0) == 0) options.privateKeyPath = argument.substr(14);
+            else if (argument.rfind("--public-key-out=", 0) == 0) options.publicKeyOut = argument.substr(17);
+            else if (argument.rfind("--latency-ms=", 0) == 0) options.latencyMs = number(13);
+            else if (argument.rfind("--jitter-ms=", 0) == 0) options.jitterMs = number(12);
+            else if (argument.rfind("--slow-rate=", 0) == 0) options.slowRate = number(12);
+            else if (argument.rfind("--slow-ms=", 0) == 0) options.slowMs = number(10);
+            else if (argument.rfind("--error-rate=", 0) == 0) options.errorRate = number(13);
+            else if (argument.rfind("--drop-rate=", 0) == 0) options.dropRate = number(12);
+            else if (argument.rfind("--stall-rate=", 0) == 0) options.stallRate = number(13);
+            else if (argument.rfind("--stall-ms=", 0) == 0) options.stallMs = number(11);
+            else if (argument.rfind("--rate-limit=", 0) == 0) options.rateLimit = number(13);
+            else if (argument.rfind("--burst=", 0) == 0) options.burst = number(8);
+            else if (argument.rfind("--tls-cert=", 0) == 0) options.tlsCertificate = argument.substr(11);
+            else if (argument.rfind("--tls-key=", 0) == 0) options.tlsKey = argument.substr(10);
+            else return false;
+        }
+        return options.port > 0 && options.port < 65536 && options.tlsCertificate.empty() == options.tlsKey.empty();
+    }
+
+    bool loadOrGenerateKey() {
+        EVP_PKEY* key = nullptr;
+        if (!options.privateKeyPath.empty()) {
+            std::FILE* in = std::fopen(options.privateKeyPath.c_str(), "r");
+            if (!in) return false;
+            key = PEM_read_PrivateKey(in, nullptr, nullptr, nullptr);
+            std::fclose(in);
+        }
+        else {
+            std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr), EVP_PKEY_CTX_free);
+            if (!ctx || EVP_PKEY_keygen_init(ctx.get()) <= 0 || EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), 2048) <= 0
+                || EVP_PKEY_keygen(ctx.get(), &key) <= 0) return false;
+        }
+        if (!key) return false;
+        signingKey.reset(key, EVP_PKEY_free);
+
+        if (options.publicKeyOut.empty()) return true;
+        std::FILE* out = std::fopen(options.publicKeyOut.c_str(), "w");
+        if (!out) return false;
+        bool written = PEM_write_PUBKEY(out, key) == 1;
+        return std::fclose(out) == 0 && written;
+    }
+
+    // The server keeps its default session cache and tickets, so clients can resume sessions.
+    bool setUpTls() {
+        tlsContext.reset(SSL_CTX_new(TLS_server_method()), SSL_CTX_free);
+        return tlsContext && SSL_CTX_use_certificate_chain_file(tlsContext.get(), options.tlsCertificate.c_str()) == 1
+            && SSL_CTX_use_PrivateKey_file(tlsContext.get(), options.tlsKey.c_str(), SSL_FILETYPE_PEM) == 1
+            && SSL_CTX_check_private_key(tlsContext.get()) == 1;
+    }
+
+    // RSA PKCS#1 v1.5 over SHA-256, base64 encoded, as the real server signs. The challenge only
+    // changes once a second, so each thread keeps its last signature.
+    std::string sign(const std::string& challenge) {
+        thread_local std::string lastChallenge;
+        thread_local std::string lastSignature;
+        if (!lastSignature.empty() && challenge == lastChallenge) return lastSignature;
+
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+        size_t length = 0;
+        if (!ctx || EVP_DigestSignInit(ctx.get(), nullptr, EVP_sha256(), nullptr, signingKey.get()) <= 0
+            || EVP_DigestSign(ctx.get(), nullptr, &length, reinterpret_cast<const unsigned char*>(challenge.data()), challenge.size()) <= 0) return "";
+        std::string signature(length, '\0');
+        if (EVP_DigestSign(ctx.get(), reinterpret_cast<unsigned char*>(&signature[0]), &length, reinterpret_cast<const unsigned char*>(challenge.data()), challenge.size()) <= 0) return "";
+
+        std::string encoded(4 * ((length + 2) / 3), '\0');
+        EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&encoded[0]), reinterpret_cast<const unsigned char*>(signature.data()), static_cast<int>(length));
+        lastChallenge = challenge;
+        lastSignature = encoded;
+        return encoded;
+    }
+
+    std::string percentDecode(const std::string& text) {
+        std::string out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) && std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+                out.push_back(static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16)));
+                i += 2;
+            }
+            else out.push_back(text[i] == '+' ? ' ' : text[i]);
+        }
+        return out;
+    }
+
+    std::string queryParameter(const std::string& query, const std::string& name) {
+        size_t position = 0;
+        while (position < query.size()) {
+            size_t end = query.find('&', position);
+            if (end == std::string::npos) end = query.size();
+            size_t equals = query.find('=', position);
+            if (equals != std::string::npos && equals < end && query.compare(position, equals - position, name) == 0)
+                return percentDecode(query.substr(equals + 1, end - equals - 1));
+            position = end + 1;
+        }
+        return "";
+    }
+
+    bool allowed(const std::string& userId) {
+        if (options.rateLimit <= 0) return true;
+        RateLimiter* limiter;
+        {
+            std::lock_guard<std::mutex> lock(limitersMutex);
+            std::unique_ptr<RateLimiter>& slot = limiters[userId];
+            if (!slot) {
+                RateLimiter::Options limit;
+                limit.requestsPerSecond = options.rateLimit;
+                limit.burst = options.burst > 0 ? options.burst : options.rateLimit;
+                limit.overLimit = RateLimiter::OverLimit::FailFast;
+                limit.adaptive = false;
+                slot.reset(new RateLimiter(limit));
+            }
+            limiter = slot.get();
+        }
+        return limiter->tryAcquire(RateLimiter::Clock::now());
+    }
+
+    std::string escapeJson(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            if (static_cast<unsigned char>(c) < 0x20) continue;
+            out.push_back(c);
+        }
+        return out;
+    }
+
+    // Returns false to drop the connection without an answer.
+    bool answer(const std::string& method, const std::string& target, int& status, std::string& body, bool& stall) {
+        size_t question = target.find('?');
+        std::string path = target.substr(0, question);
+        std::string query = question == std::string::npos ? "" : target.substr(question + 1);
+
+        if (path == "/stats") {
+            status = 200;
+            body = "{\"requests\":" + std::to_string(counters.requests.load()) + ",\"rateLimited\":" + std::to_string(counters.rateLimited.load())
+                + ",\"errors\":" + std::to_string(counters.errors.load()) + ",\"dropped\":" + std::to_string(counters.dropped.load()) + ",\"stalled\":" + std::to_string(counters.stalled.load())
+                + ",\"connections\":" + std::to_string(counters.connections.load()) + "}";
+            return true;
+        }
+
+        // /license/{userId}/{key}/verify
+        const std::string prefix = "/license/";
+        const std::string suffix = "/verify";
+        size_t separator = path.find('/', prefix.size());
+        if (path.compare(0, prefix.size(), prefix) != 0 || path.size() < prefix.size() + suffix.size() || separator == std::string::npos
+            || path.compare(path.size() - suffix.size(), suffix.size(), suffix) != 0 || separator >= path.size() - suffix.size()) {
+            status = 404;
+            body = "{\"error\":\"Not found\"}";
+            return true;
+        }
+        if (method == "HEAD") {
+            status = 200;
+            return true;
+        }
+        std::string userId = percentDecode(path.substr(prefix.size(), separator - prefix.size()));
+        std::string licenseKey = percentDecode(path.substr(separator + 1, path.size() - suffix.size() - separator - 1));
+        counters.requests.fetch_add(1, std::memory_order_relaxed);
+
+        thread_local std::mt19937_64 random(std::random_device{}());
+        std::uniform_real_distribution<double> unit(0, 1);
+        double delayMs = options.latencyMs + options.jitterMs * unit(random);
+        if (options.slowRate > 0 && unit(random) < options.slowRate) delayMs += options.slowMs;
+        if (delayMs > 0) std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(delayMs * 1000)));
+
+        if (options.dropRate > 0 && unit(random) < options.dropRate) {
+            counters.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        stall = licenseKey.compare(0, 6, "STALL-") == 0 || (options.stallRate > 0 && unit(random) < options.stallRate);
+        if (stall) counters.stalled.fetch_add(1, std::memory_order_relaxed);
+        if (options.errorRate > 0 && unit(random) < options.errorRate) {
+            counters.errors.fetch_add(1, std::memory_order_relaxed);
+            status = 500;
+            body = "{\"error\":\"Internal server error\"}";
+            return true;
+        }
+
+        std::string result = "VALID";
+        if (!allowed(userId)) {
+            counters.rateLimited.fetch_add(1, std::memory_order_relaxed);
+            status = 429;
+            result = "RATE_LIMIT_EXCEEDED";
+        }
+        else {
+            status = 200;
+            for (const char* name : resultNames) {
+                size_t length = std::strlen(name);
+                if (licenseKey.size() > length && licenseKey.compare(0, length, name) == 0 && licenseKey[length] == '-') result = name;
+            }
+        }
+
+        body = "{\"valid\":" + std::string(result == "VALID" ? "true" : "false") + ",\"result\":\"" + result + "\"";
+        std::string challenge = queryParameter(query, "challenge");
+        if (!challenge.empty()) body += ",\"signedChallenge\":\"" + escapeJson(sign(challenge)) + "\"";
+        body += "}";
+        return true;
+    }
+
+    const char* reason(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 429: return "Too Many Requests";
+        default: return "Internal Server Error";
+        }
+    }
+
+    // A client socket, read and written through TLS when the server has a certificate.
+    struct Connection {
+        int fd;
+        SSL* ssl = nullptr;
+
+        explicit Connection(int fd) : fd(fd) {}
+        ~Connection() {
+            if (ssl) {
+                if (SSL_is_init_finished(ssl)) SSL_shutdown(ssl);
+                SSL_free(ssl);
+            }
+            ::close(fd);
+        }
+
+        bool accept() {
+            if (!tlsContext) return true;
+            ssl = SSL_new(tlsContext.get());
+            return ssl && SSL_set_fd(ssl, fd) == 1 && SSL_accept(ssl) == 1;
+        }
+
+        ssize_t receive(char* data, size_t size) {
+            if (!ssl) return ::recv(fd, data, size, 0);
+            return SSL_read(ssl, data, static_cast<int>(size));
+        }
+
+        bool sendAll(const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                ssize_t written = ssl ? SSL_write(ssl, data.data() + sent, static_cast<int>(data.size() - sent))
+                    : ::send(fd, data.data() + sent, data.size() - sent, 0);
+                if (written <= 0) return false;
+                sent += static_cast<size_t>(written);
+            }
+            return true;
+        }
+    };
+
+    // HTTP/1.1 with keep-alive. Requests carry no body; anything but GET and HEAD is refused.
+    void serve(int fd) {
+        Connection connection(fd);
+        if (!connection.accept()) return;
+        std::string buffer;
+        char chunk[4096];
+        for (;;) {
+            size_t headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                if (buffer.size() > 64 * 1024) return;
+                ssize_t received = connection.receive(chunk, sizeof(chunk));
+                if (received <= 0) return;
+                buffer.append(chunk, static_cast<size_t>(received));
+            }
+            std::string head = buffer.substr(0, headerEnd);
+            buffer.erase(0, headerEnd + 4);
+
+            std::istringstream lines(head);
+            std::string method, target, version;
+            lines >> method >> target >> version;
+            std::string lower = head;
+            for (char& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            bool close = version == "HTTP/1.0" || lower.find("\nconnection: close") != std::string::npos;
+
+            int status = 405;
+            std::string body = "{\"error\":\"Method not allowed\"}";
+            bool stall = false;
+            if ((method == "GET" || method == "HEAD") && !answer(method, target, status, body, stall)) return;
+
+            std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason(status) + "\r\nContent-Type: application/json\r\nContent-Length: "
+                + std::to_string(body.size()) + "\r\n" + (close ? "Connection: close\r\n" : "") + "\r\n";
+            if (method != "HEAD") response += body;
+            if (stall) {
+                size_t half = response.size() - body.size() / 2;
+                if (!connection.sendAll(response.substr(0, half))) return;
+                std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(options.stallMs * 1000)));
+                response.erase(0, half);
+            }
+            if (!connection.sendAll(response) || close) return;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (!parseArguments(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!loadOrGenerateKey()) {
+        std::cerr << "licensegate_mock_server: cannot load or generate the signing key" << std::endl;
+        return 1;
+    }
+    if (!options.tlsCertificate.empty() && !setUpTls()) {
+        std::cerr << "licensegate_mock_server: cannot load the TLS certificate or key" << std::endl;
+        return 1;
+    }
+
+    // A client that hangs up mid-answer must not take the server down.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (listener < 0 || inet_pton(AF_INET, options.bind.c_str(), &address.sin_addr) != 1
+        || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 1024) != 0) {
+        std::cerr << "licensegate_mock_server: cannot listen on " << options.bind << ":" << options.port << std::endl;
+        return 1;
+    }
+    std::cerr << "licensegate_mock_server: listening on " << (tlsContext ? "https://" : "http://") << options.bind << ":" << options.port << std::endl;
+
+    // One thread per connection, so an injected delay holds only its own connection.
+    for (;;) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        counters.connections.fetch_add(1, std::memory_order_relaxed);
+        std::thread(serve, fd).detach();
+    }
+}